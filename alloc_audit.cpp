@@ -0,0 +1,226 @@
+#include "alloc_audit.hpp"
+
+#ifdef CLIMB_ALLOC_AUDIT
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+#ifdef __GLIBC__
+#include <execinfo.h>
+#endif
+
+// frames of call stack kept per call site, not counting operator new itself
+static const int site_depth = 4;
+static const unsigned int site_capacity = 1024;
+
+struct CallSite
+{
+	void* stack[site_depth];
+	uint64_t count;
+	uint64_t bytes;
+};
+
+// fixed size so recording never allocates
+static CallSite sites[site_capacity];
+static unsigned int sites_used = 0;
+static uint64_t sites_dropped = 0;
+
+// read by every thread's operator new, written by the main thread
+static std::atomic<bool> counting {false};
+static uint64_t frame_allocs = 0;
+static uint64_t frame_bytes = 0;
+static uint64_t total_allocs = 0;
+static uint64_t total_bytes = 0;
+static uint64_t frames = 0;
+static uint64_t allocating_frames = 0;
+
+// only the thread that called alloc_audit_start is audited
+static thread_local bool audited_thread = false;
+// set while the audit itself is running so it doesn't count itself
+static thread_local bool in_audit = false;
+
+// caller is the return address of operator new
+static void record(std::size_t size, void* caller)
+{
+	in_audit = true;
+
+	++frame_allocs;
+	frame_bytes += size;
+
+	void* stack[site_depth] = {caller};
+#ifdef __GLIBC__
+	// find the caller in the full stack and keep it and its callers
+	const int max_depth = site_depth + 8;
+	void* full[max_depth];
+	int depth = backtrace(full, max_depth);
+	for (int i = 0; i < depth; ++i)
+	{
+		if (full[i] != caller)
+			continue;
+		for (int j = 0; j < site_depth && i + j < depth; ++j)
+			stack[j] = full[i + j];
+		break;
+	}
+#endif
+
+	// open addressing on the stack addresses
+	uintptr_t hash = 0;
+	for (int i = 0; i < site_depth; ++i)
+		hash = hash * 31 + (uintptr_t)stack[i];
+	unsigned int slot = (hash >> 4) % site_capacity;
+	for (unsigned int probe = 0; probe < site_capacity; ++probe)
+	{
+		CallSite& site = sites[(slot + probe) % site_capacity];
+		if (site.count == 0)
+		{
+			if (sites_used * 4 >= site_capacity * 3)
+				break;
+			++sites_used;
+			std::memcpy(site.stack, stack, sizeof(site.stack));
+		}
+		else if (std::memcmp(site.stack, stack, sizeof(site.stack)) != 0)
+			continue;
+
+		++site.count;
+		site.bytes += size;
+		in_audit = false;
+		return;
+	}
+	++sites_dropped;
+
+	in_audit = false;
+}
+
+static void* allocate(std::size_t size, void* caller)
+{
+	// the audited thread first, so other threads only touch their own thread locals
+	if (audited_thread && !in_audit && counting.load(std::memory_order_relaxed))
+		record(size, caller);
+
+	void* p = std::malloc(size ? size : 1);
+	if (!p)
+		throw std::bad_alloc {};
+	return p;
+}
+
+void* operator new(std::size_t size)
+{
+	return allocate(size, __builtin_return_address(0));
+}
+
+void* operator new[](std::size_t size)
+{
+	return allocate(size, __builtin_return_address(0));
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	try
+	{
+		return allocate(size, __builtin_return_address(0));
+	}
+	catch (...)
+	{
+		return nullptr;
+	}
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+	try
+	{
+		return allocate(size, __builtin_return_address(0));
+	}
+	catch (...)
+	{
+		return nullptr;
+	}
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+	std::free(p);
+}
+
+void alloc_audit_start()
+{
+#ifdef __GLIBC__
+	// the first backtrace loads libgcc, get that over with
+	void* warmup[2];
+	backtrace(warmup, 2);
+#endif
+	audited_thread = true;
+	frame_allocs = 0;
+	frame_bytes = 0;
+	counting.store(true, std::memory_order_relaxed);
+}
+
+void alloc_audit_frame(uint64_t frame)
+{
+	if (!counting.load(std::memory_order_relaxed))
+		return;
+
+	++frames;
+	if (frame_allocs)
+	{
+		in_audit = true;
+		std::cerr << "frame " << frame << ": " << frame_allocs << " allocations, " << frame_bytes << " bytes\n";
+		in_audit = false;
+
+		++allocating_frames;
+		total_allocs += frame_allocs;
+		total_bytes += frame_bytes;
+	}
+	frame_allocs = 0;
+	frame_bytes = 0;
+}
+
+void alloc_audit_report(std::ostream& out)
+{
+	if (!counting.load(std::memory_order_relaxed))
+		return;
+	in_audit = true;
+
+	out << "Allocation audit: " << allocating_frames << " of " << frames << " frames allocated, " << total_allocs << " allocations, " << total_bytes << " bytes\n";
+
+	// biggest offenders first
+	for (unsigned int shown = 0; shown < 20; ++shown)
+	{
+		CallSite* top = nullptr;
+		for (auto& site : sites)
+		{
+			if (site.count && (!top || site.count > top->count))
+				top = &site;
+		}
+		if (!top)
+			break;
+
+		out << "  " << top->count << " allocations, " << top->bytes << " bytes from\n";
+#ifdef __GLIBC__
+		int depth = 0;
+		while (depth < site_depth && top->stack[depth])
+			++depth;
+		char** names = backtrace_symbols(top->stack, depth);
+		for (int i = 0; i < depth; ++i)
+			out << "    " << (names ? names[i] : "?") << "\n";
+		std::free(names);
+#else
+		out << "    " << top->stack[0] << "\n";
+#endif
+		top->count = 0;
+	}
+	if (sites_dropped)
+		out << "  " << sites_dropped << " allocations from untracked call sites\n";
+
+	in_audit = false;
+}
+
+#endif
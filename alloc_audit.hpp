@@ -0,0 +1,35 @@
+#ifndef ALLOC_AUDIT_HPP
+#define ALLOC_AUDIT_HPP
+
+#include <cstdint>
+#include <ostream>
+
+// Build with ALLOC_AUDIT=1 to hook operator new and report every frame that
+// allocates on the main thread, plus a summary of where the allocations came
+// from at exit. Otherwise these compile to nothing.
+
+#ifdef CLIMB_ALLOC_AUDIT
+
+// start counting on this thread, anything before (loading) isn't reported
+void alloc_audit_start();
+// report allocations since the last call
+void alloc_audit_frame(uint64_t frame);
+void alloc_audit_report(std::ostream& out);
+
+#else
+
+inline void alloc_audit_start()
+{
+}
+
+inline void alloc_audit_frame(uint64_t)
+{
+}
+
+inline void alloc_audit_report(std::ostream&)
+{
+}
+
+#endif
+
+#endif
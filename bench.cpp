@@ -0,0 +1,551 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+
+#include "bubbles.hpp"
+#include "game.hpp"
+#include "generator.hpp"
+#include "particles.hpp"
+#include "physics.hpp"
+#include "point.hpp"
+#include "preview.hpp"
+#include "rope.hpp"
+#include "sim_math.hpp"
+#include "sound.hpp"
+#include "swinger.hpp"
+
+// Every case is a body that does `ops` operations and returns something
+// derived from its work so none of it can be optimized away. The body runs
+// for a warm-up period first, which also sizes the batches, then each of
+// `repetitions` timed batches gives one ns/op sample.
+
+typedef std::chrono::steady_clock BenchClock;
+
+struct BenchResult
+{
+	std::string name;
+	double ops;
+	double median;
+	double min;
+	double mean;
+	double stddev;
+};
+
+static std::vector<BenchResult> results;
+static std::string filter;
+static unsigned int repetitions = 15;
+static const std::chrono::milliseconds warm_up {200};
+static const std::chrono::milliseconds batch_time {10};
+static volatile float sink;
+
+template <typename Body>
+static void bench(const std::string& name, double ops, Body body)
+{
+	if (!filter.empty() && name.find(filter) == std::string::npos)
+		return;
+
+	float total = 0.f;
+	unsigned long calls = 0;
+	BenchClock::time_point start = BenchClock::now();
+	do
+	{
+		total += body();
+		++calls;
+	}
+	while (BenchClock::now() - start < warm_up);
+	double call_ns = std::chrono::duration<double, std::nano>(BenchClock::now() - start).count() / calls;
+	unsigned long batch = std::max(1.0, std::chrono::duration<double, std::nano>(batch_time).count() / call_ns);
+
+	std::vector<double> samples;
+	for (unsigned int r = 0; r < repetitions; ++r)
+	{
+		start = BenchClock::now();
+		for (unsigned long i = 0; i < batch; ++i)
+			total += body();
+		samples.push_back(std::chrono::duration<double, std::nano>(BenchClock::now() - start).count() / (batch * ops));
+	}
+	sink = total;
+
+	std::sort(samples.begin(), samples.end());
+	BenchResult result {name, ops, samples[samples.size() / 2], samples.front(), 0.0, 0.0};
+	for (double s : samples)
+		result.mean += s / samples.size();
+	for (double s : samples)
+		result.stddev += (s - result.mean) * (s - result.mean) / samples.size();
+	result.stddev = std::sqrt(result.stddev);
+	results.push_back(result);
+
+	std::printf("%-28s %12.2f ns/op  min %10.2f  mean %10.2f  sd %6.1f%%\n", name.c_str(), result.median, result.min, result.mean, 100.0 * result.stddev / result.mean);
+	std::fflush(stdout);
+}
+
+// one line per result so files diff cleanly and --compare can read them back
+static bool write_json(const std::string& path)
+{
+	std::ofstream out {path};
+	out << "{\"unit\": \"ns/op\", \"repetitions\": " << repetitions << ", \"results\": [\n";
+	for (std::size_t i = 0; i < results.size(); ++i)
+	{
+		const BenchResult& r = results[i];
+		char line[256];
+		std::snprintf(line, sizeof(line), "{\"name\": \"%s\", \"ops\": %.0f, \"median\": %.3f, \"min\": %.3f, \"mean\": %.3f, \"stddev\": %.3f}",
+			r.name.c_str(), r.ops, r.median, r.min, r.mean, r.stddev);
+		out << line << (i + 1 < results.size() ? ",\n" : "\n");
+	}
+	out << "]}\n";
+	return out.good();
+}
+
+static void compare(const std::string& path)
+{
+	std::ifstream in {path};
+	if (!in)
+	{
+		std::cerr << "Failed to read " << path << std::endl;
+		return;
+	}
+
+	std::cout << "\ncompared to " << path << " (median):\n";
+	std::string line;
+	while (std::getline(in, line))
+	{
+		char name[128];
+		double median;
+		if (std::sscanf(line.c_str(), "{\"name\": \"%127[^\"]\", \"ops\": %*f, \"median\": %lf", name, &median) != 2)
+			continue;
+		for (auto& r : results)
+		{
+			if (r.name == name)
+				std::printf("%-28s %12.2f -> %10.2f ns/op  %+6.1f%%\n", name, median, r.median, 100.0 * (r.median - median) / median);
+		}
+	}
+}
+
+// a player to aim and step with, no textures or sound loaded
+struct BenchPlayers
+{
+	sf::Font font;
+	sf::Texture texture;
+	SoundBoard sounds;
+	// never created, nothing gets baked
+	SpeechBubbles bubbles {font};
+	SwingerPhysics physics;
+	RopePhysics ropes {2};
+	std::vector<Swinger*> players;
+
+	BenchPlayers()
+	{
+		physics.reserve(2);
+		players.push_back(new Swinger {0, "one", sounds, bubbles, physics, ropes, 400.f, sf::Color::Red, texture, texture, texture, texture});
+		players.push_back(new Swinger {1, "two", sounds, bubbles, physics, ropes, 1200.f, sf::Color::Blue, texture, texture, texture, texture});
+	}
+
+	~BenchPlayers()
+	{
+		for (auto& player : players)
+			delete player;
+	}
+};
+
+// a game tick for both players, prepare_step(), SwingerPhysics::step() and finish_step()
+static void bench_step(const char* name, uint8_t state)
+{
+	const unsigned int ticks = 32;
+
+	BenchPlayers rig;
+	// far enough up that pulling toward them lasts more than 32 ticks
+	Point anchors[] = {{500.f, -50000.f, rig.texture}, {1100.f, -50000.f, rig.texture}};
+
+	bench(name, ticks, [&]
+	{
+		// start from the same state every time, or pulling would turn into swinging
+		for (unsigned int i = 0; i < rig.players.size(); ++i)
+		{
+			rig.players[i]->target(state == GRAPPLE_NONE ? nullptr : &anchors[i]);
+			rig.physics.px[i] = 400.f + 800.f * i;
+			rig.physics.py[i] = 600.f;
+			rig.physics.vx[i] = 0.f;
+			rig.physics.vy[i] = 0.f;
+			if (state == GRAPPLE_SWINGING)
+			{
+				rig.physics.grappling[i] = GRAPPLE_SWINGING;
+				rig.physics.grap_dist[i] = dist(sf::Vector2f {rig.physics.px[i], rig.physics.py[i]}, anchors[i].pos());
+				rig.physics.swing_vel[i] = 0.5f;
+			}
+		}
+
+		for (unsigned int t = 0; t < ticks; ++t)
+		{
+			for (auto& player : rig.players)
+				player->prepare_step();
+			rig.physics.step(gravity, game_step, floor_y, winw);
+			for (auto& player : rig.players)
+				player->finish_step();
+		}
+		return rig.players[0]->pos().y + rig.players[1]->pos().y;
+	});
+}
+
+// aim from the bottom of the screen at `count` points scattered over it,
+// turning each time so every aim is a full scan, or holding steady
+static void bench_aim(const char* name, unsigned int count, bool steady = false)
+{
+	BenchPlayers rig;
+	sf::View camera {sf::FloatRect {0.f, 0.f, (float)winw, (float)winh}};
+	PointPool pool {rig.texture, count};
+	std::vector<Point*> points;
+	SimRandom random;
+	for (unsigned int i = 0; i < count; ++i)
+		points.push_back(pool.make((random.next() >> 8) % winw, (random.next() >> 8) % winh));
+
+	sf::Vector2f dirs[] = {{0.f, -100.f}, {70.f, -70.f}, {-70.f, -70.f}, {100.f, -20.f}};
+	unsigned int d = 0;
+	bench(name, 1, [&]
+	{
+		rig.players[0]->aim(dirs[steady ? 0 : d++ % 4], rig.players, points, pool.version(), camera);
+		return 0.f;
+	});
+
+	for (auto& point : points)
+		pool.release(point);
+}
+
+static void bench_geometry()
+{
+	const unsigned int n = 1024;
+
+	BenchPlayers rig;
+	std::vector<sf::Vector2f> a, b;
+	SimRandom random;
+	for (unsigned int i = 0; i < n; ++i)
+	{
+		a.push_back(sf::Vector2f ((random.next() >> 8) % winw, (random.next() >> 8) % winh));
+		b.push_back(sf::Vector2f ((random.next() >> 8) % winw + 1.f, (random.next() >> 8) % winh + 1.f));
+	}
+
+	sf::Vector2f dir {30.f, -90.f};
+	bench("dist2line", n, [&]
+	{
+		float sum = 0.f;
+		for (unsigned int i = 0; i < n; ++i)
+			sum += rig.players[0]->dist2line(dir, a[i]);
+		return sum;
+	});
+
+	bench("dist2", n, [&]
+	{
+		float sum = 0.f;
+		for (unsigned int i = 0; i < n; ++i)
+			sum += dist2(a[i], b[i]);
+		return sum;
+	});
+
+	bench("norm", n, [&]
+	{
+		float sum = 0.f;
+		for (unsigned int i = 0; i < n; ++i)
+			sum += norm(b[i]);
+		return sum;
+	});
+
+	bench("normv", n, [&]
+	{
+		sf::Vector2f sum;
+		for (unsigned int i = 0; i < n; ++i)
+			sum += normv(b[i]);
+		return sum.x + sum.y;
+	});
+}
+
+// one call of the endless generator, culling below and rebasing like the game does
+static void bench_generate()
+{
+	sf::Texture texture;
+	PointPool pool {texture, 64};
+	std::vector<Point*> points;
+	points.push_back(pool.make(500.f, 0.f));
+	points.push_back(pool.make(650.f, 0.f));
+	float highest_point = 0.f;
+
+	bench("generate", 1, [&]
+	{
+		generate_points(points, pool, highest_point);
+
+		// about a screen's worth is alive in play
+		float bottom = highest_point + winh;
+		for (auto it = points.begin(); it != points.end();)
+		{
+			if ((*it)->get_anchor().y - (*it)->reach() > bottom)
+			{
+				pool.release(*it);
+				it = points.erase(it);
+			}
+			else
+				++it;
+		}
+
+		if (highest_point < -10000.f)
+		{
+			for (auto& point : points)
+				point->rebase(10000.f);
+			highest_point += 10000.f;
+		}
+		return highest_point;
+	});
+
+	for (auto& point : points)
+		pool.release(point);
+}
+
+// placing 256 points, a quarter each still, along lines, sine waves and circles, per point
+static void bench_move_points()
+{
+	const unsigned int count = 256;
+
+	sf::Texture texture;
+	PointPool pool {texture, count};
+	std::vector<Point*> points;
+	for (unsigned int i = 0; i < count; ++i)
+	{
+		PointMotion motion;
+		motion.kind = i % 4;
+		motion.extent = sf::Vector2f {100.f, 20.f};
+		motion.rate = 0.002f;
+		motion.phase = i * 0.1f;
+		points.push_back(pool.make(200.f + (i * 37) % 1200, -(float)(i * 30), false, motion));
+	}
+	unsigned int tick = 0;
+
+	bench("points/move-256", count, [&]
+	{
+		move_points(points, tick++);
+		return points[count - 1]->pos().x;
+	});
+
+	for (auto& point : points)
+		pool.release(point);
+}
+
+// particle update with 50k embers alive, per particle
+static void bench_particles()
+{
+	const unsigned int alive = 50000;
+
+	Particles particles {65536};
+	// long lived so the count holds steady
+	for (unsigned int i = 0; i < alive; ++i)
+		particles.emit(i % 1600, 900.f, 0.f, -0.1f, 1e9f);
+
+	bench("particles/50k", alive, [&]
+	{
+		particles.step(16.f);
+		return (float)particles.size_alive();
+	});
+}
+
+// a swarm of swingers, a third each falling, pulling and swinging, per swinger
+static void bench_physics()
+{
+	const unsigned int swingers = 256;
+
+	SwingerPhysics physics;
+	physics.reserve(swingers);
+	for (unsigned int i = 0; i < swingers; ++i)
+	{
+		unsigned int body = physics.add(50.f + i * 6.f, 800.f - (i % 7) * 50.f, 16.f, 16.f);
+		physics.tx[body] = 50.f + ((i * 37) % 1500);
+		physics.ty[body] = 100.f + (i % 3) * 150.f;
+		physics.grappling[body] = i % 3 ? GRAPPLE_PULLING : GRAPPLE_NONE;
+	}
+
+	bench("physics/256-swingers", swingers, [&]
+	{
+		physics.step(gravity, 16.f, 900.f, 1600.f);
+		return physics.py[0];
+	});
+}
+
+// a frame of release arcs for both players swinging among 100 points, with
+// the release velocity changing enough each frame to fly new arcs, or holding
+// steady so the last arcs are carried forward
+static void bench_preview(const char* name, bool steady)
+{
+	const unsigned int count = 100;
+
+	BenchPlayers rig;
+	PointPool pool {rig.texture, count};
+	std::vector<Point*> points;
+	SimRandom random;
+	for (unsigned int i = 0; i < count; ++i)
+		points.push_back(pool.make((random.next() >> 8) % winw, (random.next() >> 8) % winh));
+	for (unsigned int i = 0; i < rig.players.size(); ++i)
+		rig.players[i]->target(points[i]);
+
+	TrajectoryPreview preview;
+	preview.enabled = true;
+	unsigned int frame = 0;
+	bench(name, 1, [&]
+	{
+		for (unsigned int i = 0; i < rig.players.size(); ++i)
+		{
+			rig.physics.vx[i] = steady ? 0.3f : 0.3f + (frame % 8) * 0.05f;
+			rig.physics.vy[i] = -0.6f;
+			rig.players[i]->finish_step();
+		}
+		++frame;
+		preview.update(rig.players, points, (float)winh);
+		return 0.f;
+	});
+
+	for (auto& point : points)
+		pool.release(point);
+}
+
+// a tick of eight ropes, half of them let go halfway through each swing
+static void bench_ropes()
+{
+	const unsigned int count = 8;
+	RopePhysics ropes {count};
+	for (unsigned int r = 0; r < count; ++r)
+		ropes.add();
+	unsigned int tick = 0;
+
+	bench("ropes/8x32", 1, [&]
+	{
+		unsigned int phase = tick % 64;
+		for (unsigned int r = 0; r < count; ++r)
+		{
+			sf::Vector2f anchor {100.f + r * 180.f, 300.f};
+			float angle = tick * 0.05f + r;
+			sf::Vector2f from = anchor + sf::Vector2f {std::sin(angle), std::cos(angle)} * 200.f;
+			if (phase == 0)
+				ropes.attach(r, from, anchor);
+			else if (phase == 32 && r % 2)
+				ropes.release(r);
+			if (ropes.state[r] == ROPE_HELD)
+				ropes.hold(r, from, anchor);
+		}
+		ropes.step(gravity, game_step);
+		++tick;
+		return ropes.y[RopePhysics::segments / 2 * count];
+	});
+}
+
+// throughput of a math backend on the operations the simulation uses
+template <typename Math>
+static void bench_math(const std::string& name)
+{
+	const unsigned int n = 4096;
+
+	float in[n];
+	SimRandom random;
+	for (unsigned int i = 0; i < n; ++i)
+		in[i] = (random.next() >> 8) / 16777216.f * 2000.f - 1000.f;
+
+	bench(name + "/sqrt", n, [&]
+	{
+		float sum = 0.f;
+		for (unsigned int i = 0; i < n; ++i)
+			sum += Math::sqrt(in[i] * in[i] + 1.f);
+		return sum;
+	});
+
+	bench(name + "/sin+cos", n, [&]
+	{
+		float sum = 0.f;
+		for (unsigned int i = 0; i < n; ++i)
+			sum += Math::sin(in[i]) + Math::cos(in[i]);
+		return sum;
+	});
+
+	bench(name + "/atan2", n, [&]
+	{
+		float sum = 0.f;
+		for (unsigned int i = 0; i < n; ++i)
+			sum += Math::atan2(in[i], in[(i + 1) % n]);
+		return sum;
+	});
+
+	// the swing constraint: normalize the tangent, then pin to the rope length
+	float px = 100.f, py = 0.f, vel = 0.01f;
+	bench(name + "/swing-step", n, [&]
+	{
+		for (unsigned int i = 0; i < n; ++i)
+		{
+			float tx = py, ty = -px;
+			float tn = Math::sqrt(tx * tx + ty * ty);
+			vel += 0.003f * (ty / tn) * 16.f;
+			px += tx / tn * vel * 16.f;
+			py += ty / tn * vel * 16.f;
+			float d = Math::sqrt(px * px + py * py);
+			px *= 100.f / d;
+			py *= 100.f / d;
+		}
+		return px + py;
+	});
+}
+
+int main(int argc, char* argv[])
+{
+	std::string json_path;
+	std::string compare_path;
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		if (arg == "--json" && i + 1 < argc)
+			json_path = argv[++i];
+		else if (arg == "--compare" && i + 1 < argc)
+			compare_path = argv[++i];
+		else if (arg == "--filter" && i + 1 < argc)
+			filter = argv[++i];
+		else if (arg == "--repetitions" && i + 1 < argc && std::atoi(argv[i + 1]) > 0)
+			repetitions = std::atoi(argv[++i]);
+		else
+		{
+			std::cerr << "Usage: " << argv[0] << " [--json FILE] [--compare FILE] [--filter TEXT] [--repetitions N]\n";
+			return 1;
+		}
+	}
+
+	// the game's window and world
+	winw = 1600;
+	winh = 900;
+	floor_y = winh;
+	gravity = sf::Vector2f {0.f, 0.003f};
+
+	bench_step("step/falling", GRAPPLE_NONE);
+	bench_step("step/pulling", GRAPPLE_PULLING);
+	bench_step("step/swinging", GRAPPLE_SWINGING);
+	bench_aim("aim/10", 10);
+	bench_aim("aim/100", 100);
+	bench_aim("aim/10000", 10000);
+	bench_aim("aim/10000-steady", 10000, true);
+	bench_geometry();
+	bench_generate();
+	bench_move_points();
+	bench_particles();
+	bench_physics();
+	bench_ropes();
+	bench_preview("preview/2-players", false);
+	bench_preview("preview/2-players-steady", true);
+	bench_math<FloatMath>("math/float");
+	bench_math<FixedMath>("math/fixed");
+
+	if (!compare_path.empty())
+		compare(compare_path);
+	if (!json_path.empty() && !write_json(json_path))
+	{
+		std::cerr << "Failed to write " << json_path << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,96 @@
+#include <cmath>
+
+#include "bubbles.hpp"
+#include "draw.hpp"
+
+SpeechBubbles::SpeechBubbles(const sf::Font& f)
+	: font {f}
+{
+	style(text, box);
+	bubbles.reserve(max_bubbles);
+}
+
+void SpeechBubbles::style(sf::Text& line, sf::RectangleShape& line_box) const
+{
+	line.setFont(font);
+	line.setCharacterSize(20);
+	line.setColor(sf::Color::Black);
+	line_box.setFillColor(sf::Color::White);
+	line_box.setOrigin(margin, margin);
+}
+
+bool SpeechBubbles::create(unsigned int w, unsigned int h)
+{
+	ready = atlas.create(w, h);
+	if (ready)
+	{
+		atlas.clear(sf::Color::Transparent);
+		atlas.display();
+	}
+	return ready;
+}
+
+const SpeechBubbles::Bubble* SpeechBubbles::get(const sf::String& line)
+{
+	for (auto& bubble : bubbles)
+	{
+		if (bubble.text == line)
+			return &bubble;
+	}
+
+	if (!ready || bubbles.size() == max_bubbles)
+	{
+		++overflows;
+		return nullptr;
+	}
+
+	clock.restart();
+	text.setString(line);
+	sf::FloatRect bounds = text.getLocalBounds();
+	// the same box Swinger used to draw around its text, and a pixel between bubbles
+	unsigned int w = std::ceil(bounds.width + 4 * margin);
+	unsigned int h = std::ceil(bounds.height + 4 * margin);
+	sf::Vector2u size = atlas.getSize();
+	if (row_x + w + 1 > size.x)
+	{
+		row_x = 0;
+		row_y += row_height + 1;
+		row_height = 0;
+	}
+	if (w + 1 > size.x || row_y + h + 1 > size.y)
+	{
+		++overflows;
+		return nullptr;
+	}
+
+	// drawn with the box's corner at row_x, row_y
+	sf::Vector2f corner {(float)row_x + margin, (float)row_y + margin};
+	box.setSize(sf::Vector2f {bounds.width + 4 * margin, bounds.height + 4 * margin});
+	box.setPosition(corner);
+	text.setPosition(corner);
+	atlas.setView(atlas.getDefaultView());
+	draw(atlas, box);
+	draw(atlas, text);
+	atlas.display();
+
+	bubbles.push_back(Bubble {line, sf::IntRect {(int)row_x, (int)row_y, (int)w, (int)h}, bounds});
+	row_x += w + 1;
+	if (h > row_height)
+		row_height = h;
+
+	if (baking_started)
+		++late_bakes;
+	sf::Int64 us = clock.getElapsedTime().asMicroseconds();
+	if (us > bake_max)
+		bake_max = us;
+	return &bubbles.back();
+}
+
+void SpeechBubbles::report(std::ostream& out) const
+{
+	if (bubbles.empty() && overflows == 0)
+		return;
+
+	out << "Speech bubbles: " << bubbles.size() << " baked, " << late_bakes << " during play, " << overflows << " drawn without the atlas"
+		<< ", bake max " << bake_max << " us" << std::endl;
+}
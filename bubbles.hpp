@@ -0,0 +1,75 @@
+#ifndef BUBBLES_HPP
+#define BUBBLES_HPP
+
+#include <ostream>
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+
+// Speech bubbles, the white box with a line of text in it, rendered once into
+// an atlas so a player who is speaking costs one sprite instead of laying out
+// and drawing the text every frame. Lines are baked the first time they're
+// asked for; bake the ones you know about up front so it doesn't happen in
+// the middle of play.
+class SpeechBubbles
+{
+public:
+	struct Bubble
+	{
+		sf::String text;
+		// where it is in texture()
+		sf::IntRect rect;
+		// of the text on its own, for placing the bubble
+		sf::FloatRect bounds;
+	};
+private:
+	// bubbles stay where they are so players can hold on to them
+	static const unsigned int max_bubbles = 128;
+	// box edge around the text, the text sits at this offset in the box
+	static const int margin = 5;
+
+	const sf::Font& font;
+	sf::RenderTexture atlas;
+	bool ready = false;
+	std::vector<Bubble> bubbles;
+
+	// packing into rows
+	unsigned int row_x = 0;
+	unsigned int row_y = 0;
+	unsigned int row_height = 0;
+
+	sf::Text text;
+	sf::RectangleShape box;
+
+	bool baking_started = false;
+	unsigned int late_bakes = 0;
+	unsigned int overflows = 0;
+	sf::Clock clock;
+	sf::Int64 bake_max = 0;
+public:
+	SpeechBubbles(const sf::Font& f);
+
+	// needs a GL context, without an atlas get() always returns nullptr
+	bool create(unsigned int w, unsigned int h);
+
+	// the bubble for a line, baking it if it's new, nullptr if it doesn't fit
+	const Bubble* get(const sf::String& line);
+
+	// from here on bakes are counted as happening during play
+	inline void start_play()
+	{
+		baking_started = true;
+	}
+
+	inline const sf::Texture& texture() const
+	{
+		return atlas.getTexture();
+	}
+
+	// how a line is styled, for drawing the ones that didn't fit
+	void style(sf::Text& line, sf::RectangleShape& line_box) const;
+
+	void report(std::ostream& out) const;
+};
+
+#endif
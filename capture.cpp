@@ -0,0 +1,338 @@
+#ifdef __linux__
+// pixel buffer objects are GL 2.1, libGL exports them directly
+#define GL_GLEXT_PROTOTYPES
+#include <GL/gl.h>
+#include <GL/glext.h>
+#define CAPTURE_PBO
+#endif
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#include "capture.hpp"
+#include "trace.hpp"
+
+FrameCapture::~FrameCapture()
+{
+	stop();
+}
+
+bool FrameCapture::start(CaptureFormat fmt, const std::string& out, unsigned int w, unsigned int h)
+{
+	stop();
+
+	format = fmt;
+	path = out;
+	width = w;
+	height = h;
+
+	if (format == CAPTURE_RAW)
+	{
+		raw.open(path, std::ios::binary | std::ios::trunc);
+		if (!raw)
+			return false;
+	}
+	else
+	{
+		// fine if it's already there, saving the first frame will tell
+#ifdef _WIN32
+		_mkdir(path.c_str());
+#else
+		mkdir(path.c_str(), 0755);
+#endif
+	}
+
+	use_pbo = false;
+	use_sync = false;
+#ifdef CAPTURE_PBO
+	int major = 0, minor = 0;
+	const char* version = (const char*)glGetString(GL_VERSION);
+	if (version && std::sscanf(version, "%d.%d", &major, &minor) == 2 && (major > 2 || (major == 2 && minor >= 1)))
+	{
+		use_pbo = true;
+		const char* extensions = (const char*)glGetString(GL_EXTENSIONS);
+		use_sync = major > 3 || (major == 3 && minor >= 2) || (extensions && std::strstr(extensions, "GL_ARB_sync"));
+		for (auto& slot : slots)
+		{
+			glGenBuffers(1, &slot.pbo);
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+			glBufferData(GL_PIXEL_PACK_BUFFER, width * height * 4, nullptr, GL_STREAM_READ);
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	}
+#endif
+	for (auto& slot : slots)
+	{
+		slot.state = SLOT_FREE;
+		if (use_pbo)
+			continue;
+		if (!slot.texture.create(width, height))
+			return false;
+		slot.copy.resize(width * height * 4);
+	}
+	reading_head = 0;
+	reading_count = 0;
+	queue_head = 0;
+	queue_count = 0;
+	done_count = 0;
+
+	// raw frames have to land in order, PNGs can compress in parallel
+	unsigned int threads = 1;
+	if (format == CAPTURE_PNG)
+		threads = std::max(1u, std::min(4u, std::thread::hardware_concurrency() - 1));
+	stopping = false;
+	for (unsigned int i = 0; i < threads; ++i)
+		workers.push_back(std::thread {&FrameCapture::worker, this});
+
+	running = true;
+	return true;
+}
+
+void FrameCapture::stop()
+{
+	if (!running)
+		return;
+
+	while (reading_count)
+		collect(true);
+
+	{
+		std::lock_guard<std::mutex> lock {mutex};
+		stopping = true;
+	}
+	work.notify_all();
+	for (auto& thread : workers)
+		thread.join();
+	workers.clear();
+	reclaim();
+
+#ifdef CAPTURE_PBO
+	for (auto& slot : slots)
+	{
+		if (slot.pbo)
+			glDeleteBuffers(1, &slot.pbo);
+		slot.pbo = 0;
+	}
+#endif
+	raw.close();
+	running = false;
+}
+
+void FrameCapture::grab(sf::RenderWindow& window)
+{
+	if (!running)
+		return;
+
+	TraceSpan span {"capture-grab"};
+	clock.restart();
+	window.setActive();
+
+	reclaim();
+	// the oldest readback has had a couple of frames to finish, if the GPU is
+	// still on it this frame goes instead of waiting
+	bool ready = reading_count < readback_depth || collect(false);
+
+	unsigned int s = 0;
+	while (s < pool_size && slots[s].state != SLOT_FREE)
+		++s;
+
+	if (!ready || s == pool_size)
+	{
+		// the GPU or the workers are behind
+		++dropped;
+	}
+	else
+	{
+		Slot& slot = slots[s];
+#ifdef CAPTURE_PBO
+		if (use_pbo)
+		{
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+			glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+			if (use_sync)
+				slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		}
+		else
+#endif
+		{
+			slot.texture.update(window);
+		}
+		slot.state = SLOT_READING;
+		slot.number = grabs;
+		reading[(reading_head + reading_count) % readback_depth] = s;
+		++reading_count;
+	}
+	++grabs;
+
+	sf::Int64 us = clock.getElapsedTime().asMicroseconds();
+	grab_total += us;
+	if (us > grab_max)
+		grab_max = us;
+}
+
+bool FrameCapture::collect(bool wait)
+{
+	unsigned int s = reading[reading_head];
+	Slot& slot = slots[s];
+#ifdef CAPTURE_PBO
+	if (slot.fence)
+	{
+		GLsync fence = (GLsync)slot.fence;
+		// mapping an unfinished buffer would block until the GPU gets there
+		GLenum status;
+		do
+			status = glClientWaitSync(fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, wait ? 1000000000 : 0);
+		while (wait && status == GL_TIMEOUT_EXPIRED);
+		if (status == GL_TIMEOUT_EXPIRED)
+			return false;
+		glDeleteSync(fence);
+		slot.fence = nullptr;
+	}
+#endif
+	reading_head = (reading_head + 1) % readback_depth;
+	--reading_count;
+
+#ifdef CAPTURE_PBO
+	if (use_pbo)
+	{
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+		// stays mapped until the workers are done with it
+		slot.pixels = (const uint8_t*)glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		slot.bottom_up = true;
+	}
+	else
+#endif
+	{
+		sf::Image image = slot.texture.copyToImage();
+		std::memcpy(slot.copy.data(), image.getPixelsPtr(), slot.copy.size());
+		slot.pixels = slot.copy.data();
+		slot.bottom_up = false;
+	}
+
+	if (!slot.pixels)
+	{
+		slot.state = SLOT_FREE;
+		++dropped;
+		return true;
+	}
+
+	slot.state = SLOT_QUEUED;
+	{
+		std::lock_guard<std::mutex> lock {mutex};
+		queue[(queue_head + queue_count) % pool_size] = s;
+		++queue_count;
+	}
+	work.notify_one();
+	return true;
+}
+
+void FrameCapture::reclaim()
+{
+	unsigned int finished[pool_size];
+	unsigned int count;
+	{
+		std::lock_guard<std::mutex> lock {mutex};
+		count = done_count;
+		std::copy(done, done + count, finished);
+		done_count = 0;
+	}
+
+	for (unsigned int i = 0; i < count; ++i)
+	{
+		Slot& slot = slots[finished[i]];
+#ifdef CAPTURE_PBO
+		if (use_pbo)
+		{
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		}
+#endif
+		slot.pixels = nullptr;
+		slot.state = SLOT_FREE;
+	}
+}
+
+void FrameCapture::worker()
+{
+	const std::size_t row = width * 4;
+	// for PNGs, which want the top row first
+	std::vector<uint8_t> upright;
+	if (trace_enabled.load(std::memory_order_relaxed))
+		trace_thread_name("capture");
+
+	for (;;)
+	{
+		unsigned int s;
+		{
+			std::unique_lock<std::mutex> lock {mutex};
+			work.wait(lock, [this] { return queue_count || stopping; });
+			// only leave once the queue is drained
+			if (!queue_count)
+				return;
+			s = queue[queue_head];
+			queue_head = (queue_head + 1) % pool_size;
+			--queue_count;
+		}
+		const Slot& slot = slots[s];
+		TraceSpan span {"capture-write"};
+
+		bool ok;
+		if (format == CAPTURE_RAW)
+		{
+			if (slot.bottom_up)
+			{
+				for (unsigned int y = height; y-- > 0;)
+					raw.write((const char*)slot.pixels + y * row, row);
+			}
+			else
+			{
+				raw.write((const char*)slot.pixels, row * height);
+			}
+			ok = raw.good();
+		}
+		else
+		{
+			const uint8_t* pixels = slot.pixels;
+			if (slot.bottom_up)
+			{
+				upright.resize(row * height);
+				for (unsigned int y = 0; y < height; ++y)
+					std::memcpy(&upright[y * row], slot.pixels + (height - 1 - y) * row, row);
+				pixels = upright.data();
+			}
+
+			char name[32];
+			std::snprintf(name, sizeof(name), "/frame_%06llu.png", (unsigned long long)slot.number);
+			sf::Image image;
+			image.create(width, height, pixels);
+			ok = image.saveToFile(path + name);
+		}
+		span.end();
+
+		std::lock_guard<std::mutex> lock {mutex};
+		done[done_count++] = s;
+		if (ok)
+			++written;
+		else
+			++failed;
+	}
+}
+
+void FrameCapture::report(std::ostream& out) const
+{
+	if (grabs == 0)
+		return;
+
+	out << "Capture: " << grabs << " frames grabbed, " << written << " written to " << path << ", " << dropped << " dropped, " << failed << " failed"
+		<< ", grab cost avg " << (float)grab_total / grabs << " us max " << grab_max << " us (" << (use_pbo ? "pixel buffers" : "textures") << ")" << std::endl;
+}
@@ -0,0 +1,125 @@
+#ifndef CAPTURE_HPP
+#define CAPTURE_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+
+enum CaptureFormat
+{
+	// numbered PNGs in a directory
+	CAPTURE_PNG,
+	// one file of back to back top-down RGBA frames
+	CAPTURE_RAW,
+};
+
+// Records the window without stalling the game. grab() starts reading the
+// frame back from the GPU into one of a fixed pool of buffers and hands the
+// one from a few grabs ago, which has usually arrived by then, to worker
+// threads that compress and write it. If that readback's fence hasn't
+// signalled yet, or every buffer is still busy, the frame is dropped and
+// counted rather than waited for.
+//
+// On Linux the buffers are pixel buffer objects, which the workers read while
+// they're mapped, so the game thread never copies pixels. Elsewhere they fall
+// back to textures, where the copy to memory blocks.
+class FrameCapture
+{
+	static const unsigned int pool_size = 8;
+	// grabs a readback gets before it's collected
+	static const unsigned int readback_depth = 3;
+
+	enum SlotState
+	{
+		SLOT_FREE,
+		SLOT_READING,
+		// with the workers
+		SLOT_QUEUED,
+	};
+
+	struct Slot
+	{
+		SlotState state = SLOT_FREE;
+		uint64_t number = 0;
+		// pixel buffer object, or 0 when going through the texture
+		unsigned int pbo = 0;
+		// GLsync after the readback, null without sync objects
+		void* fence = nullptr;
+		sf::Texture texture;
+		std::vector<uint8_t> copy;
+		// what the workers read, straight from GL it's bottom row first
+		const uint8_t* pixels = nullptr;
+		bool bottom_up = false;
+	};
+
+	CaptureFormat format = CAPTURE_PNG;
+	std::string path;
+	unsigned int width = 0;
+	unsigned int height = 0;
+	bool running = false;
+	bool use_pbo = false;
+	// GL 3.2 or ARB_sync, to check on a readback without waiting for it
+	bool use_sync = false;
+
+	Slot slots[pool_size];
+	// slots being read back, oldest first, game thread only
+	unsigned int reading[readback_depth];
+	unsigned int reading_head = 0;
+	unsigned int reading_count = 0;
+
+	// guarded by mutex
+	unsigned int queue[pool_size];
+	unsigned int queue_head = 0;
+	unsigned int queue_count = 0;
+	unsigned int done[pool_size];
+	unsigned int done_count = 0;
+	bool stopping = false;
+	uint64_t written = 0;
+	uint64_t failed = 0;
+
+	std::mutex mutex;
+	std::condition_variable work;
+	std::vector<std::thread> workers;
+	std::ofstream raw;
+
+	uint64_t grabs = 0;
+	uint64_t dropped = 0;
+	sf::Clock clock;
+	sf::Int64 grab_total = 0;
+	sf::Int64 grab_max = 0;
+
+	// hand the oldest readback to the workers, false if it isn't done and wait is false
+	bool collect(bool wait);
+	// take back the slots the workers are finished with
+	void reclaim();
+	void worker();
+public:
+	FrameCapture() = default;
+	FrameCapture(const FrameCapture&) = delete;
+	FrameCapture& operator=(const FrameCapture&) = delete;
+	~FrameCapture();
+
+	// the window's context has to be active
+	bool start(CaptureFormat fmt, const std::string& out, unsigned int w, unsigned int h);
+	// finish the frames in flight and wait for the workers, the context has to be active here too
+	void stop();
+
+	inline bool is_running() const
+	{
+		return running;
+	}
+
+	// call after drawing the frame and before display()
+	void grab(sf::RenderWindow& window);
+
+	void report(std::ostream& out) const;
+};
+
+#endif
@@ -0,0 +1,20 @@
+#version 130
+
+uniform float winw;
+uniform float winh;
+uniform float time; // running time of game
+uniform float start_time; // when the intro ended
+uniform sampler2D texture;
+
+// cheap full screen pass for everything above the lava (see fragment.glsl)
+
+void main()
+{
+	vec4 normpix = texture2D(texture, vec2(gl_FragCoord.x / winw, gl_FragCoord.y / winh));
+
+	// if the intro is over, darken
+	if (start_time >= 0.f)
+		normpix /= (1.0 + smoothstep(start_time, start_time + 0.2, time) * 0.3);
+
+	gl_FragColor = gl_Color * normpix;
+}
@@ -0,0 +1,9 @@
+#include "draw.hpp"
+
+unsigned int draw_calls;
+
+void draw(sf::RenderTarget& target, const sf::Drawable& drawable, const sf::RenderStates& states)
+{
+	++draw_calls;
+	target.draw(drawable, states);
+}
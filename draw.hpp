@@ -0,0 +1,12 @@
+#ifndef DRAW_HPP
+#define DRAW_HPP
+
+#include <SFML/Graphics.hpp>
+
+// draw calls issued this frame
+extern unsigned int draw_calls;
+
+// draw and count it
+void draw(sf::RenderTarget& target, const sf::Drawable& drawable, const sf::RenderStates& states = sf::RenderStates::Default);
+
+#endif
@@ -1,5 +1,19 @@
 #version 130
 
+// quality settings, the game injects these for each tier (see shaders.cpp)
+#ifndef SAMPLES
+#define SAMPLES 10
+#endif
+#ifndef GLOWSIZE
+#define GLOWSIZE 5.0
+#endif
+#ifndef NOISE
+#define NOISE 1
+#endif
+#ifndef BLOOM
+#define BLOOM 1
+#endif
+
 uniform float winw;
 uniform float winh;
 uniform float time; // running time of game
@@ -88,11 +102,10 @@ vec4 tex_at(vec2 pix)
 // calculate bloom at a pixel with color and size
 vec4 bloom(vec2 pix, vec4 color, float glowsize)
 {
-	int samples = 10;
-
 	vec4 source = tex_at(pix);
+#if BLOOM
 	vec4 sum = vec4(0);
-	int diff = (samples - 1) / 2;
+	const int diff = (SAMPLES - 1) / 2;
 	vec2 sizeFactor = vec2(glowsize);
 
 	for (int x = -diff; x <= diff; x++)
@@ -104,21 +117,32 @@ vec4 bloom(vec2 pix, vec4 color, float glowsize)
 		}
 	}
 
-	return ((sum / (samples * samples)) + source) * color;
+	return ((sum / float(SAMPLES * SAMPLES)) + source) * color;
+#else
+	// stand in for the blur with the center pixel, over a flat area the full blur adds 81 taps / 100
+	return (source * 1.81) * color;
+#endif
 }
 
 // gl_FragCoord is 0,0 in bottom left, 1,1 in top right
+// once the intro is over this only runs over the bottom band of the screen,
+// darken.glsl handles the rest
 
 void main()
 {
+#if NOISE
 	float n1 = snoise(gl_FragCoord.xy * 20.0 / vec2(winw, winh) + vec2(time, -time));
 	float n2 = snoise(gl_FragCoord.xy * 5.0 / vec2(winw, winh) + vec2(time / 3.0, -time / 2.0));
+#else
+	float n1 = 0.0;
+	float n2 = 0.0;
+#endif
 	vec4 lava = vec4(1.2, 0.1 * n2, 0.0, 1.0);
 
 	// calculate normal pixels
 	vec4 normpix = tex_at(gl_FragCoord.xy);
 	// calculate glow
-	vec4 glowpix = bloom(gl_FragCoord.xy + vec2(n1), lava, 5.0);
+	vec4 glowpix = bloom(gl_FragCoord.xy + vec2(n1), lava, GLOWSIZE);
 
 	float t = 1.0;
 
@@ -0,0 +1,18 @@
+#define _USE_MATH_DEFINES
+#include <cmath>
+
+#include "game.hpp"
+
+unsigned int winw;
+unsigned int winh;
+unsigned int game_tick;
+float game_time;
+sf::Vector2f gravity;
+float floor_y;
+
+SimRandom sim_random;
+
+float rad2deg(float rad)
+{
+	return (rad * 180.f) / M_PI;
+}
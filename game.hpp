@@ -0,0 +1,68 @@
+#ifndef GAME_HPP
+#define GAME_HPP
+
+#include <cstdint>
+
+#include <SFML/System.hpp>
+
+#include "sim_math.hpp"
+
+// state the whole game shares, set up by main()
+
+extern unsigned int winw;
+extern unsigned int winh;
+const unsigned int game_step = 16;
+// ticks simulated since the game started
+extern unsigned int game_tick;
+// simulated seconds, game_tick * game_step
+extern float game_time;
+extern sf::Vector2f gravity;
+// y of the floor in world coordinates (moves when the origin is rebased)
+extern float floor_y;
+
+// game randomness, reproducible across platforms given the seed
+extern SimRandom sim_random;
+
+inline float randmf()
+{
+	return (sim_random.next() >> 8) / 16777215.f;
+}
+
+inline uint32_t randm(uint32_t max)
+{
+	return sim_random.next() % max;
+}
+
+float rad2deg(float rad);
+
+inline float dot(const sf::Vector2f& v1, const sf::Vector2f& v2)
+{
+	return v1.x * v2.x + v1.y * v2.y;
+}
+
+inline float dist2(const sf::Vector2f& p1, const sf::Vector2f& p2)
+{
+	return (p1.x - p2.x) * (p1.x - p2.x) + (p1.y - p2.y) * (p1.y - p2.y);
+}
+
+inline float dist(const sf::Vector2f& p1, const sf::Vector2f& p2)
+{
+	return SimMath::sqrt(dist2(p1, p2));
+}
+
+inline float norm2(const sf::Vector2f& v)
+{
+	return v.x * v.x + v.y * v.y;
+}
+
+inline float norm(const sf::Vector2f& v)
+{
+	return SimMath::sqrt(norm2(v));
+}
+
+inline sf::Vector2f normv(const sf::Vector2f& v)
+{
+	return v / norm(v);
+}
+
+#endif
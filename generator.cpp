@@ -0,0 +1,93 @@
+#define _USE_MATH_DEFINES
+#include <cmath>
+
+#include "game.hpp"
+#include "generator.hpp"
+
+static const float min_dist = 150.f;
+static const float easy_dist = 350.f;
+static const float hard_dist = 600.f;
+// one in this many new points moves
+static const unsigned int moving_odds = 4;
+
+static PointMotion random_motion()
+{
+	PointMotion motion;
+	if (randm(moving_odds) != 0)
+		return motion;
+
+	motion.kind = randm(3) + MOTION_LINEAR;
+	float size = 60.f + randmf() * 60.f;
+	if (motion.kind == MOTION_CIRCLE)
+	{
+		motion.extent = sf::Vector2f {size, 0.f};
+	}
+	else
+	{
+		// mostly side to side
+		float theta = (randmf() - 0.5f) * M_PI / 2.f;
+		motion.extent = sf::Vector2f {SimMath::cos(theta) * size, SimMath::sin(theta) * size};
+	}
+	// a cycle every 2 to 4 seconds
+	motion.rate = 2.f * M_PI / (2000.f + randmf() * 2000.f);
+	motion.phase = randmf() * 2.f * M_PI;
+	return motion;
+}
+
+void generate_points(std::vector<Point*>& points, PointPool& pool, float& highest_point)
+{
+	float last_highest = highest_point;
+	int last_size = points.size();
+	// generate 1-4 more points
+	unsigned int new_points = randm(3) + 2;
+
+	while (points.size() - last_size < new_points)
+	{
+		for (auto& point : points)
+		{
+			// random angle
+			int side = randm(2);
+			float theta = (randmf() + 1.f) * M_PI / 9.f;
+			if (side)
+				theta = -theta;
+			else
+				theta = theta - M_PI;
+
+			int difficulty = (randm(2) == 0 ? easy_dist : hard_dist);
+
+			// hop from where the point is anchored, not where it's moved to
+			const sf::Vector2f& from = point->get_anchor();
+			sf::Vector2f p {from.x + SimMath::cos(theta) * difficulty, from.y + SimMath::sin(theta) * difficulty};
+			PointMotion motion = random_motion();
+			float reach = motion.reach();
+
+			// want it in bounds and at least one point higher than the previous
+			// XXX copied from Swinger class
+			if (p.y < last_highest && p.x - reach > 200.f && p.x + reach < winw - 200.f)
+			{
+				// make sure it isn't too close to other points, wherever they both move to
+				bool bad = false;
+				for (auto& ps : points)
+				{
+					float space = min_dist + reach + ps->reach();
+					if (dist2(ps->get_anchor(), p) < space * space)
+					{
+						bad = true;
+						break;
+					}
+				}
+				if (!bad)
+				{
+					points.push_back(pool.make(p.x, p.y, false, motion));
+
+					if (p.y < highest_point)
+					{
+						highest_point = p.y;
+					}
+					// need to break because iterator is invalid now
+					break;
+				}
+			}
+		}
+	}
+}
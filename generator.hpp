@@ -0,0 +1,12 @@
+#ifndef GENERATOR_HPP
+#define GENERATOR_HPP
+
+#include <vector>
+
+#include "point.hpp"
+
+// the endless part of the level: add 2-4 points above highest_point, each a
+// hop from one already there, and raise highest_point to the new top
+void generate_points(std::vector<Point*>& points, PointPool& pool, float& highest_point);
+
+#endif
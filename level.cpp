@@ -0,0 +1,67 @@
+#include <cstring>
+#include <fstream>
+
+#include "level.hpp"
+
+// what used to be written out in main(), for the 1600x900 window with the floor at the bottom
+static const LevelPoint opening[] =
+{
+	// starting points
+	{1600.f / 3.f, 400.f, 0},
+	{3200.f / 3.f, 400.f, 0},
+	// ladder
+	{3200.f / 3.f + 80.f, 500.f, 0},
+	{3200.f / 3.f + 80.f, 650.f, 0},
+	// long grapple
+	{3200.f / 3.f - 450.f, 800.f, LEVEL_POINT_BOOST},
+	// segue to normal gen
+	{500.f, 1000.f, 0},
+	{650.f, 1000.f, 0},
+};
+
+LevelPack::LevelPack()
+{
+	use_opening();
+}
+
+void LevelPack::use_opening()
+{
+	file.close();
+	std::memcpy(header.magic, level_magic, sizeof(header.magic));
+	header.flags = LEVEL_ENDLESS;
+	header.seed = 0;
+	header.points = sizeof(opening) / sizeof(opening[0]);
+	points = opening;
+	next_point = 0;
+}
+
+bool LevelPack::open(const std::string& path)
+{
+	LevelHeader h;
+	if (!file.open_read(path) || file.size() < sizeof(h))
+	{
+		use_opening();
+		return false;
+	}
+
+	std::memcpy(&h, file.data(), sizeof(h));
+	// only the header is checked, the points are paged in as they're reached
+	if (std::memcmp(h.magic, level_magic, sizeof(h.magic)) || (file.size() - sizeof(h)) / sizeof(LevelPoint) < h.points)
+	{
+		use_opening();
+		return false;
+	}
+
+	header = h;
+	points = (const LevelPoint*)((const char*)file.data() + sizeof(h));
+	next_point = 0;
+	return true;
+}
+
+bool LevelPack::write(const std::string& path) const
+{
+	std::ofstream out {path, std::ios::binary | std::ios::trunc};
+	out.write((const char*)&header, sizeof(header));
+	out.write((const char*)points, header.points * sizeof(LevelPoint));
+	return out.good();
+}
@@ -0,0 +1,103 @@
+#ifndef LEVEL_HPP
+#define LEVEL_HPP
+
+#include <cstdint>
+#include <string>
+
+#include "mapped_file.hpp"
+
+// Level packs: hand-authored grapple points, read straight out of a mapped
+// file. A pack is a LevelHeader followed by `points` LevelPoints sorted by
+// height, lowest first, so the game only ever reads a little past the top of
+// the screen and a tower of any size opens instantly. Everything is
+// little-endian.
+
+const char level_magic[4] = {'C', 'L', 'V', '1'};
+
+struct LevelHeader
+{
+	char magic[4];
+	// LEVEL_* bits
+	uint32_t flags;
+	// for the game's randomness each run, 0 to pick one at startup
+	uint32_t seed;
+	uint32_t points;
+};
+
+static_assert(sizeof(LevelHeader) == 16, "level header layout changed");
+
+struct LevelPoint
+{
+	// pixels from the left of the 1600 pixel wide play area
+	float x;
+	// pixels above the floor
+	float height;
+	// LEVEL_POINT_* bits
+	uint32_t flags;
+};
+
+static_assert(sizeof(LevelPoint) == 12, "level point layout changed");
+
+// header flags
+enum : uint32_t
+{
+	// carry on with generated points after the last authored one
+	LEVEL_ENDLESS = 1,
+};
+
+// point flags
+enum : uint32_t
+{
+	// grappling it speeds up the camera, like the one at the top of the opening
+	LEVEL_POINT_BOOST = 1,
+};
+
+class LevelPack
+{
+	MappedFile file;
+	LevelHeader header {};
+	const LevelPoint* points = nullptr;
+	uint32_t next_point = 0;
+
+	void use_opening();
+public:
+	// the opening everyone knows, then endless generated points
+	LevelPack();
+
+	// map a pack, back to the opening if it isn't valid
+	bool open(const std::string& path);
+	// write the current level as a pack
+	bool write(const std::string& path) const;
+
+	inline uint32_t seed() const
+	{
+		return header.seed;
+	}
+
+	inline bool endless() const
+	{
+		return header.flags & LEVEL_ENDLESS;
+	}
+
+	// start streaming from the bottom again
+	inline void rewind()
+	{
+		next_point = 0;
+	}
+
+	// every authored point has been streamed
+	inline bool done() const
+	{
+		return next_point == header.points;
+	}
+
+	// the next point at or below `height`, nullptr when there are none yet
+	inline const LevelPoint* next(float height)
+	{
+		if (next_point == header.points || points[next_point].height > height)
+			return nullptr;
+		return &points[next_point++];
+	}
+};
+
+#endif
@@ -1,32 +1,35 @@
 #define _USE_MATH_DEFINES
+#include <algorithm>
 #include <cmath>
+#include <cstdio>
 #include <cstdlib>
 #include <ctime>
 #include <iostream>
-#include <list>
-#include <sstream>
 #include <vector>
 
 #include <SFML/Graphics.hpp>
 #include <SFML/Audio.hpp>
 
-unsigned int winw;
-unsigned int winh;
-const unsigned int game_step = 16;
-float game_time;
-sf::Vector2f gravity;
-
-using std::rand;
-
-float randmf()
-{
-	return rand() / (float)RAND_MAX;
-}
-
-uint32_t randm(uint32_t max)
-{
-	return rand() % max;
-}
+#include "alloc_audit.hpp"
+#include "bubbles.hpp"
+#include "capture.hpp"
+#include "draw.hpp"
+#include "game.hpp"
+#include "generator.hpp"
+#include "level.hpp"
+#include "particles.hpp"
+#include "physics.hpp"
+#include "point.hpp"
+#include "preview.hpp"
+#include "rope.hpp"
+#include "scene.hpp"
+#include "shaders.hpp"
+#include "sim_math.hpp"
+#include "sound.hpp"
+#include "spectate.hpp"
+#include "swinger.hpp"
+#include "telemetry.hpp"
+#include "trace.hpp"
 
 bool load(sf::Texture& tex, const std::string& file)
 {
@@ -38,577 +41,159 @@ bool load(sf::Texture& tex, const std::string& file)
 	return true;
 }
 
-float rad2deg(float rad)
-{
-	return (rad * 180.f) / M_PI;
-}
-
-float dot(const sf::Vector2f& v1, const sf::Vector2f& v2)
-{
-	return v1.x * v2.x + v1.y * v2.y;
-}
-
-float dist2(const sf::Vector2f& p1, const sf::Vector2f& p2)
-{
-	return (p1.x - p2.x) * (p1.x - p2.x) + (p1.y - p2.y) * (p1.y - p2.y);
-}
-
-float dist(const sf::Vector2f& p1, const sf::Vector2f& p2)
-{
-	return sqrtf(dist2(p1, p2));
-}
-
-float norm2(const sf::Vector2f& v)
-{
-	return v.x * v.x + v.y * v.y;
-}
-
-float norm(const sf::Vector2f& v)
-{
-	return sqrtf(norm2(v));
-}
-
-sf::Vector2f normv(const sf::Vector2f& v)
-{
-	return v / norm(v);
-}
-
-class Grappable
-{
-protected:
-	sf::Vector2f position;
-	sf::Vector2f velocity;
-public:
-	Grappable(float x, float y)
-		: position {x, y}, velocity {0.f, 0.f}
-	{}
-
-	Grappable(const sf::Vector2f& v)
-		: position {v}
-	{}
-
-	inline const sf::Vector2f& pos() const
-	{
-		return position;
-	}
-
-	inline const sf::Vector2f& vel() const
-	{
-		return velocity;
-	}
-};
-
-class Point : public Grappable
-{
-	sf::Sprite sprite;
-public:
-	Point(float x, float y, const sf::Texture& texture)
-		: Grappable {x, y}, sprite {texture}
-	{
-		auto s = texture.getSize();
-		sprite.setOrigin(s.x / 2.f, s.y / 2.f);
-		sprite.setScale(4.f, 4.f);
-		sprite.setPosition(position);
-	}
-
-	void draw_on(sf::RenderTexture& render_target)
-	{
-		render_target.draw(sprite);
-	}
-};
-
-class Swinger : public Grappable
+// turns wall clock time into game_step ticks, optionally sped up or slowed down
+class SimClock
 {
-	std::string name;
-
-	sf::Sprite avatar;
-	sf::Sprite reticle;
-	sf::Sprite aimbox;
-	sf::Sprite rope;
-
-	Grappable* grapple_target = nullptr;
-	Grappable* nearest = nullptr;
-	// 0 = not grappling, 1 = moving toward point, 2 = swingin'
-	int grappling = 0;
-
-	float max_grap_dist = 200.f;
-	float max_grap_dist2;
-	float grap_dist;
-
-	float pull_speed_factor = 0.004f;
-	float min_pull_speed = 0.04f;
-
-	float aiming = false;
-
-	float max_target_dist = 400.f;
-	float max_target_dist2;
-
-	// velocity in the reference frame of swinging
-	float swing_vel = 0.f;
-	float starting_swing_vel = 0.004f;
-
-	int need_center = 0;
-
-	sf::Vector2f last_target_pos;
-
-	int lives = 2;
-
-	float half_height;
-	float half_width;
+	sf::Clock frame_timer;
+	sf::Clock tick_timer;
+	sf::Int64 pending_us = 0;
 
-	int index;
-
-	sf::Text textbox;
-	sf::RectangleShape textboxbox;
-	sf::Clock texttimer;
-	float texttime = -1.f;
-	sf::FloatRect textbounds;
-	sf::ConvexShape textarrow;
-
-	bool dead = false;
-	bool reviving = false;
-	sf::Clock dead_timer;
+	// stop ticking when a frame has spent this long simulating so we still draw
+	const sf::Int64 tick_budget_us = 12000;
 public:
-	Swinger(int i, const std::string& nm, const sf::Font& font, float x, const sf::Color& color, const sf::Texture& avatar_tex, const sf::Texture& reticle_tex,  const sf::Texture& aimbox_tex, const sf::Texture& rope_tex)
-		: Grappable {x, 0.f}, name {nm}, avatar {avatar_tex}, reticle {reticle_tex}, aimbox {aimbox_tex}, rope {rope_tex}
-	{
-		index = i;
-		auto s = avatar_tex.getSize();
-		float scale = 4.f;
-		half_height = s.y * scale / 2.f;
-		half_width = s.x * scale / 2.f;
-		position.y = winh - half_height;
-
-		avatar.setOrigin(s.x / 2.f, s.y / 2.f);
-		avatar.setScale(scale * (index == 1 ? -1.f : 1.f), scale);
-		avatar.setColor(color);
-
-		s = reticle_tex.getSize();
-		reticle.setOrigin(s.x / 2.f, s.y / 2.f);
-		reticle.setScale(scale, scale);
-		reticle.setColor(color);
-
-		s = aimbox_tex.getSize();
-		aimbox.setOrigin(s.x / -2.f, s.y / 2.f);
-		aimbox.setScale(scale, scale);
-		aimbox.setColor(sf::Color {color.r, color.g, color.b, 100});
-
-		s = rope_tex.getSize();
-		rope.setOrigin(0.f, s.y / 2.f);
-		rope.setColor(sf::Color {(sf::Uint8)(color.r / 3), (sf::Uint8)(color.g / 3), (sf::Uint8)(color.b / 3)});
-
-		max_grap_dist2 = max_grap_dist * max_grap_dist;
-		max_target_dist2 = max_target_dist * max_target_dist;
-
-		textbox.setFont(font);
-		textbox.setCharacterSize(20);
-		textbox.setColor(sf::Color::Black);
-		textboxbox.setFillColor(sf::Color::White);
-		textboxbox.setOrigin(5.f, 5.f);
-		textarrow.setPointCount(3);
-		textarrow.setPoint(0, sf::Vector2f {0.f, 10.f});
-		textarrow.setPoint(1, sf::Vector2f {1.f, 0.f});
-		textarrow.setPoint(2, sf::Vector2f {0.f, -10.f});
-		textarrow.setFillColor(sf::Color::White);
-		textarrow.setOrigin(0.f, 5.f);
-	}
+	// simulated time per real time, 0 = as fast as possible
+	float scale = 1.f;
 
-	const std::string& get_name()
+	void start_frame()
 	{
-		return name;
+		sf::Int64 us = frame_timer.restart().asMicroseconds();
+		pending_us += us * scale;
+		// don't try to catch up on more than a few frames after a stall
+		sf::Int64 max_pending = 100000 * (scale > 1.f ? scale : 1.f);
+		if (pending_us > max_pending)
+			pending_us = max_pending;
+		tick_timer.restart();
 	}
 
-	void say(const std::string& txt, float time)
+	// wall clock time since the frame started
+	sf::Time frame_time() const
 	{
-		textbox.setString(txt);
-		textbounds = textbox.getLocalBounds();
-		textboxbox.setSize(sf::Vector2f{textbounds.width + 20.f, textbounds.height + 20.f});
-		texttimer.restart();
-		texttime = time;
+		return frame_timer.getElapsedTime();
 	}
 
-	void lament(const std::string nm)
+	// if another tick is due this frame, advance game time and return true
+	bool tick()
 	{
-		int r = randm(10);
-		std::string l;
-		switch (r)
+		if (tick_timer.getElapsedTime().asMicroseconds() > tick_budget_us)
+			return false;
+		if (scale > 0.f)
 		{
-			case 0:
-				l = nm + "!? " + nm + "!!!!";
-				break;
-			case 1:
-				l = nm + ", I'LL NEVER LET GO!";
-				break;
-			case 2:
-				l = nm + "! WHY????";
-				break;
-			case 3:
-				l = nm + ", I WILL TELL YOUR FAMILY THAT YOU LOVE THEM!";
-				break;
-			case 4:
-				l = nm + "... HE WAS ONLY TWO DAYS FROM RETIREMENT...";
-				break;
-			case 5:
-				l = "NO! " + nm + "! TAKE ME INSTEAD!";
-				break;
-			case 6:
-				l = "I CAN'T BEAR TO LIVE WITHOUT YOU, " + nm + "!";
-				break;
-			case 7:
-				l = nm + "! HOW DID IT COME TO THIS???";
-				break;
-			case 8:
-				l = "I WILL LOVE YOU FOREVER, " + nm + "!";
-				break;
-			case 9:
-				l = "I MUST BE STRONG. FOR " + nm + "!";
-				break;
+			if (pending_us < game_step * 1000)
+				return false;
+			pending_us -= game_step * 1000;
 		}
-		say(l, 3);
-	}
-
-	int get_lives() const
-	{
-		return lives;
-	}
 
-	float get_half_height() const
-	{
-		return half_height;
-	}
-
-	void die()
-	{
-		--lives;
-		let_go();
-		stop_aim();
-		texttime = -1.f;
-		dead = true;
-		dead_timer.restart();
+		++game_tick;
+		game_time = game_tick * game_step / 1000.f;
+		return true;
 	}
 
-	bool is_dead() const
+	// [ and ] halve and double speed, backslash toggles unthrottled
+	void handle_event(const sf::Event& event)
 	{
-		return dead;
-	}
-
-	bool need_revive() const
-	{
-		return dead && lives >= 0 && dead_timer.getElapsedTime().asSeconds() > 2.f;
-	}
-
-	bool is_reviving() const
-	{
-		return reviving;
-	}
-
-	void revive()
-	{
-		dead = false;
-		reviving = true;
-	}
-
-	bool is_grappling() const
-	{
-		return grappling != 0;
-	}
-
-	inline Grappable* target() const
-	{
-		return grapple_target;
-	}
-
-	void target(Grappable* new_target)
-	{
-		grapple_target = new_target;
-		if (grapple_target)
-			grappling = 1;
-	}
-
-	void step()
-	{
-		if (dead)
+		if (event.type != sf::Event::KeyReleased)
 			return;
 
-		// nothing to do if not grappling
-		if (!grapple_target)
-		{
-			velocity += gravity * (float)game_step;
-			position += velocity * (float)game_step;
-
-			if (position.x > winw - half_height)
-			{
-				position.x = winw - half_height;
-				velocity.x = velocity.x / -2.f;
-			}
-			else if (position.x < half_width)
-			{
-				position.x = half_width;
-				velocity.x = velocity.x / -2.f;
-			}
-
-			// don't fall through floor
-			if (position.y > winh - half_height)
-			{
-				velocity.x = 0.f;
-				velocity.y = 0.f;
-				position.y = winh - half_height;
-			}
+		if (event.key.code == sf::Keyboard::Key::LBracket && scale > 0.25f)
+			scale /= 2.f;
+		else if (event.key.code == sf::Keyboard::Key::RBracket && scale > 0.f && scale < 16.f)
+			scale *= 2.f;
+		else if (event.key.code == sf::Keyboard::Key::BackSlash)
+			scale = scale > 0.f ? 0.f : 1.f;
+		else
 			return;
-		}
 
-		float d2 = dist2(position, grapple_target->pos());
-		// need to move towards grapple
-		if (d2 > max_grap_dist2)
-		{
-			// pull speed proportional to distance
-			float speed = sqrtf(d2 - max_grap_dist2) * pull_speed_factor;
-			// until you're close
-			if (speed < min_pull_speed)
-				speed = min_pull_speed;
-
-			velocity = normv(grapple_target->pos() - position) * speed;
-
-			position += velocity * (float)game_step;
-		}
-		// if we're close enough, start swinging
-		else if (grappling == 1)
-		{
-			grap_dist = dist(position, grapple_target->pos());
-			grappling = 2;
-			reviving = false;
-			last_target_pos = grapple_target->pos();
-			swing_vel = (position.x < grapple_target->pos().x ? 1 : -1) * ((position.y - grapple_target->pos().y) + grap_dist) * starting_swing_vel / 2.f;
-		}
-
-		// if swinging
-		if (grappling == 2)
-		{
-			// direction to player
-			sf::Vector2f grap = position - grapple_target->pos();
-			// tanget of swing direction
-			sf::Vector2f grap_perp {grap.y, -grap.x};
-			// normalized
-			sf::Vector2f grap_perpn = normv(grap_perp);
-
-			// naive velocity/position update
-			swing_vel += dot(gravity, grap_perpn) * (float)game_step;
-			velocity = grap_perpn * swing_vel;
-			position += velocity * (float)game_step;
-
-			// force position into grapple distance
-			sf::Vector2f delta = position - grapple_target->pos();
-			position = grapple_target->pos() + delta * (grap_dist / norm(delta));
-
-			last_target_pos = grapple_target->pos();
-		}
+		pending_us = 0;
+		if (scale > 0.f)
+			std::cerr << "Time scale " << scale << "x\n";
+		else
+			std::cerr << "Time scale unthrottled\n";
 	}
+};
 
-	// aim and find nearest grapple to aim
-	void aim(const sf::Vector2f& dir, const std::vector<Swinger*>& players, const std::list<Point*>& points, const sf::View& camera)
-	{
-		if (dead)
-			return;
-
-		float theta = atan2f(dir.y, dir.x);
-		aimbox.setRotation(rad2deg(theta));
-		aiming = true;
+void write_trace(const std::string& path)
+{
+	if (!trace_enabled.load(std::memory_order_relaxed))
+		return;
 
-		nearest = nullptr;
-		float ndist2 = -1.f;
+	long events = trace_write(path);
+	if (events < 0)
+		std::cerr << "Failed to write trace " << path << std::endl;
+	else
+		std::cerr << "Trace: " << events << " spans written to " << path << std::endl;
+}
 
-		for (auto& player : players)
+int main(int argc, char* argv[])
+{
+	std::string telemetry_path = "climb.telemetry";
+	std::string spectate_path;
+	std::string capture_path;
+	std::string trace_path;
+	std::string level_path;
+	std::string export_level_path;
+	CaptureFormat capture_format = CAPTURE_PNG;
+	// -1 = benchmark at startup
+	int shader_tier = find_shader_tier("high");
+	SimClock sim;
+	bool show_preview = false;
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		if (arg == "--telemetry" && i + 1 < argc)
+			telemetry_path = argv[++i];
+		else if (arg == "--no-telemetry")
+			telemetry_path.clear();
+		else if (arg == "--quality" && i + 1 < argc && (std::string {argv[i + 1]} == "auto" || find_shader_tier(argv[i + 1]) >= 0))
+			shader_tier = find_shader_tier(argv[++i]);
+		else if (arg == "--time-scale" && i + 1 < argc && (std::atof(argv[i + 1]) == 0.f || (std::atof(argv[i + 1]) >= 0.25f && std::atof(argv[i + 1]) <= 16.f)))
+			sim.scale = std::atof(argv[++i]);
+		else if (arg == "--spectate" && i + 1 < argc)
+			spectate_path = argv[++i];
+		else if ((arg == "--capture" || arg == "--capture-raw") && i + 1 < argc)
 		{
-			// can't grapple self
-			if (player == this)
-				continue;
-
-			// can't grapple someone grappling self
-			if (player->target() == this)
-				continue;
-
-			// can't grapple dead players
-			if (player->is_dead())
-				continue;
-
-			// skip players already being grappled
-			bool already_targeted = false;
-			for (auto& player2 : players)
-			{
-				if (player2->target() == player)
-				{
-					already_targeted = true;
-					break;
-				}
-			}
-			if (already_targeted)
-				continue;
-
-			float ldist2 = dist2line(dir, player->pos());
-			if (ldist2 < 0.f)
-				continue;
-
-			if (nearest == nullptr || ldist2 < ndist2)
-			{
-				nearest = player;
-				ndist2 = ldist2;
-			}
+			capture_path = argv[++i];
+			capture_format = arg == "--capture" ? CAPTURE_PNG : CAPTURE_RAW;
 		}
-
-		float top = camera.getCenter().y - camera.getSize().y / 2.f;
-
-		for (auto& point : points)
+		else if (arg == "--trace" && i + 1 < argc)
+			trace_path = argv[++i];
+		else if (arg == "--level" && i + 1 < argc)
+			level_path = argv[++i];
+		else if (arg == "--export-level" && i + 1 < argc)
+			export_level_path = argv[++i];
+		else if (arg == "--preview")
+			show_preview = true;
+		else
 		{
-			// can't target stuff off screen
-			if (point->pos().y < top)
-				continue;
-			// skip points already being grappled
-			bool already_targeted = false;
-			for (auto& player : players)
-			{
-				if (player->target() == point)
-				{
-					already_targeted = true;
-					break;
-				}
-			}
-			if (already_targeted)
-				continue;
-
-			float ldist2 = dist2line(dir, point->pos());
-			if (ldist2 < 0.f)
-				continue;
-
-			if (nearest == nullptr || ldist2 < ndist2)
-			{
-				nearest = point;
-				ndist2 = ldist2;
-			}
+			std::cerr << "Usage: " << argv[0] << " [--telemetry FILE | --no-telemetry] [--quality low|medium|high|auto] [--time-scale 0.25-16 | 0] [--spectate SOCKET] [--capture DIR | --capture-raw FILE] [--trace FILE] [--level FILE] [--export-level FILE] [--preview]\n";
+			return 1;
 		}
 	}
 
-	void stop_aim()
-	{
-		aiming = false;
-		nearest = nullptr;
-	}
-
-	// return distance squared from p to the ray from position to position+dir (or -1 if not near ray)
-	float dist2line(const sf::Vector2f& dir, const sf::Vector2f& p)
-	{
-		float dt = dot(p - position, dir) / (norm(p - position) * norm(dir));
-		if (dt <= 0.7071f)
-			return -1.f;
-		if (dist2(p, position) > max_target_dist2)
-			return -1.f;
-
-		float num = dir.y * p.x - dir.x * p.y + position.y * (position.x + dir.x) - position.x * (position.y + dir.y);
-		float ldist2 = (num * num) / norm2(dir);
-
-		return ldist2;
-	}
-
-	void grapple()
+	// authored points, streamed in as the camera climbs
+	LevelPack level;
+	if (!level_path.empty() && !level.open(level_path))
+		std::cerr << "Failed to load level " << level_path << ", playing the usual one" << std::endl;
+	if (!export_level_path.empty())
 	{
-		if (dead)
-			return;
-		if (nearest)
-			target(nearest);
-	}
-
-	void let_go()
-	{
-		reviving = false;
-		grappling = 0;
-		if (grapple_target)
-			velocity += grapple_target->vel();
-		grapple_target = nullptr;
-		return;
-	}
-
-	void draw_rope_on(sf::RenderTexture& render_target)
-	{
-		if (grapple_target == nullptr)
-			return;
-
-		auto bounds = rope.getLocalBounds();
-		rope.setScale(4.f, 4.f);
-		rope.setTextureRect(sf::IntRect {0, 0, (int)(dist(position, grapple_target->pos()) / 4.f), (int)bounds.height});
-
-		rope.setPosition(position);
-		sf::Vector2f dir = grapple_target->pos() - position;
-		rope.setRotation(rad2deg(atan2f(dir.y, dir.x)));
-		render_target.draw(rope);
-	}
-
-	bool is_speaking()
-	{
-		return texttimer.getElapsedTime().asSeconds() < texttime;
-	}
-
-	void draw_on(sf::RenderTexture& render_target, const sf::View& camera)
-	{
-		avatar.setPosition(position);
-		render_target.draw(avatar);
-
-		// textbox
-		if (is_speaking())
+		if (!level.write(export_level_path))
 		{
-			auto& center = camera.getCenter();
-			auto& size = camera.getSize();
-
-			sf::Vector2f boxcorner {0.f, center.y - size.y / 2.f + 20.f + 2.f * half_height};
-			if (index)
-			{
-				boxcorner.x = center.x + size.x / 2.f - 15.f - textbounds.width;
-			}
-			else
-			{
-				boxcorner.x = center.x - size.x / 2.f + 10.f;
-			}
-			sf::Vector2f boxcenter = boxcorner + sf::Vector2f{textbounds.width / 2.f, textbounds.height / 2.f};
-
-			textboxbox.setPosition(boxcorner);
-			render_target.draw(textboxbox);
-
-			textarrow.setPosition(boxcenter);
-			textarrow.setScale(dist(boxcenter, position) / 2.f, 1.f);
-			textarrow.setRotation(rad2deg(atan2f(position.y - boxcenter.y, position.x - boxcenter.x)));
-			render_target.draw(textarrow);
-
-			textbox.setPosition(boxcorner);
-			render_target.draw(textbox);
+			std::cerr << "Failed to write level " << export_level_path << std::endl;
+			return 1;
 		}
+		return 0;
 	}
 
-	void draw_target_on(sf::RenderTexture& render_target)
-	{
-		if (aiming)
-		{
-			aimbox.setPosition(position);
-			render_target.draw(aimbox);
-
-			if (nearest)
-			{
-				reticle.setPosition(nearest->pos());
-				reticle.setRotation(game_time * 10 + 45 * index);
-				render_target.draw(reticle);
-			}
-		}
-	}
+	// always-on per-frame metrics, about 18 minutes of history at 60 FPS
+	Telemetry telemetry;
+	if (!telemetry_path.empty() && !telemetry.open(telemetry_path, 65536))
+		std::cerr << "Failed to open telemetry file " << telemetry_path << std::endl;
+	uint64_t frame_count = 0;
 
-	void draw_lives_on(sf::RenderTexture& render_target)
-	{
-		for (int i = 0; i < lives; ++i)
-		{
-			avatar.setPosition(sf::Vector2f{index * winw - (30.f + i * 60.f) * (2 * index - 1), 30.f});
-			render_target.draw(avatar);
-		}
-	}
-};
+	// live state for climb-spectator
+	SpectateServer spectate;
+	if (!spectate_path.empty() && !spectate.open(spectate_path))
+		std::cerr << "Failed to open spectator socket " << spectate_path << std::endl;
 
-int main(int argc, char* argv[])
-{
 	for (int i = 0; i < 2; ++i)
 	{
 		if (!sf::Joystick::isConnected(i))
@@ -618,7 +203,7 @@ int main(int argc, char* argv[])
 		}
 	}
 
-	srand(time(nullptr));
+	sim_random.seed(time(nullptr));
 	//sf::VideoMode mode = sf::VideoMode::getFullscreenModes()[0];
 	winw = 1600;
 	winh = 900;
@@ -636,8 +221,16 @@ int main(int argc, char* argv[])
 		return 1;
 	}
 
+	if (shader_tier < 0)
+	{
+		// lava pass can have a quarter of a 60 FPS frame
+		shader_tier = benchmark_shader_tiers("fragment.glsl", winw, winh, 4.f);
+		if (shader_tier < 0)
+			shader_tier = 0;
+	}
+
 	sf::Shader fx;
-	if (!fx.loadFromFile("fragment.glsl", sf::Shader::Fragment))
+	if (!load_shader_variant(fx, "fragment.glsl", shader_tiers[shader_tier]))
 	{
 		std::cerr << "Failed to load fragment shader\n";
 		return 1;
@@ -646,9 +239,41 @@ int main(int argc, char* argv[])
 	fx.setParameter("winw", (float)winw);
 	fx.setParameter("winh", (float)winh);
 
+	// once the intro is over the lava only reaches the bottom of the screen (fragment.glsl blends
+	// back to the plain pixel at gl_FragCoord.y + noise * 10 >= 200), so the rest gets a cheap pass
+	sf::Shader darken;
+	if (!darken.loadFromFile("darken.glsl", sf::Shader::Fragment))
+	{
+		std::cerr << "Failed to load darken shader\n";
+		return 1;
+	}
+	darken.setParameter("texture", sf::Shader::CurrentTexture);
+	darken.setParameter("winw", (float)winw);
+	darken.setParameter("winh", (float)winh);
+
+	const int lava_band = 224;
+	sf::Sprite lava {render_target.getTexture(), sf::IntRect {0, (int)winh - lava_band, (int)winw, lava_band}};
+	lava.setPosition(0.f, winh - lava_band);
+	sf::RenderStates lava_states {&fx};
+	lava_states.blendMode = sf::BlendNone;
+
+	// the main thread's span buffer is allocated here, not mid-game, and before
+	// the capture workers start so they make and name theirs up front
+	if (!trace_path.empty())
+		trace_start();
+
+	// record everything shown in the window
+	FrameCapture capture;
+	window.setActive();
+	if (!capture_path.empty() && !capture.start(capture_format, capture_path, winw, winh))
+		std::cerr << "Failed to start capture to " << capture_path << std::endl;
+
 	gravity.x = 0.f;
 	gravity.y = 0.003f;
 
+	// rebase the origin when the camera gets this many tiles above it
+	const int rebase_tiles = 16;
+
 	sf::Font font;
 	font.loadFromFile("/usr/share/fonts/TTF/DejaVuSansMono.ttf");
 
@@ -695,14 +320,57 @@ int main(int argc, char* argv[])
 	if (!load(point_tex, "img/point.png"))
 		return 1;
 
+	// background, floor and signs, cached up to two background tiles above the view
+	Scene scene;
+	float scene_tile = bg_tex.getSize().y * 4.f;
+	if (!scene.create(winw, winh + 2 * scene_tile, scene_tile))
+		std::cerr << "Failed to create scene cache, drawing layers directly" << std::endl;
+
+	// more than ever fit on screen
+	const unsigned int point_capacity = 256;
+	PointPool point_pool {point_tex, point_capacity};
+
 	sf::Music music;
 	bool have_music;
 	have_music = music.openFromFile("Jumalten short.ogg");
 
+	SoundBoard sounds;
+	sounds.load();
+
+	const char* player_names[2] = {"GIUSEPPE", "FRANK"};
+	const char* intro_lines[2] = {"FRANK! THE FLOOR IS LAVA!", "GIUSEPPE! WHAT DO WE DO NOW?"};
+
+	// everything the players say is known up front, bake it all now
+	SpeechBubbles bubbles {font};
+	if (!bubbles.create(1024, 1024))
+		std::cerr << "Failed to create speech bubble atlas, drawing text instead" << std::endl;
+	for (auto line : intro_lines)
+		bubbles.get(line);
+	for (auto name : player_names)
+	{
+		for (int r = 0; r < Swinger::lament_count; ++r)
+			bubbles.get(Swinger::lament_line(name, r));
+	}
+	bubbles.start_play();
+
+	// where players would fly if they let go, toggled with P
+	TrajectoryPreview preview;
+	preview.enabled = show_preview;
+
+	// anything allocated from here on is worth knowing about
+	alloc_audit_start();
+
 	bool restart = true;
 	while (restart)
 	{
 		fx.setParameter("start_time", -1.f);
+		darken.setParameter("start_time", -1.f);
+		floor_y = winh;
+		// challenge levels play out the same every time
+		if (level.seed())
+			sim_random.seed(level.seed());
+		level.rewind();
+		preview.reset();
 
 		sf::View camera = render_target.getDefaultView();
 		float camera_speed_factor = -0.0005f;
@@ -717,6 +385,9 @@ int main(int argc, char* argv[])
 		bg.setScale(bg_scale, bg_scale);
 		bg.setTextureRect(sf::IntRect{0, 0, (int)bg_s.x, (int)(winh / bg_scale) + (int)bg_s.y});
 		bg.setPosition(0, -(int)bg_s.y);
+		float bg_tile = bg_s.y * bg_scale;
+		// total distance the world has been shifted down by rebasing
+		double origin_offset = 0.0;
 
 		sf::Sprite floor {floor_tex};
 		floor.setScale(4.f, 4.f);
@@ -740,11 +411,18 @@ int main(int argc, char* argv[])
 		snap.setScale(4.f, 4.f);
 		snap.setPosition(winw / 2.f, winh / 2.f - winh);
 
+		SwingerPhysics physics;
+		physics.reserve(2);
+		RopePhysics ropes {2};
+
 		std::vector<Swinger*> players;
 		players.push_back(new Swinger {
 			0,
-			"GIUSEPPE",
-			font,
+			player_names[0],
+			sounds,
+			bubbles,
+			physics,
+			ropes,
 			1.f * winw / 3.f,
 			sf::Color {45, 185, 210},
 			avatar_tex,
@@ -754,8 +432,11 @@ int main(int argc, char* argv[])
 		});
 		players.push_back(new Swinger {
 			1,
-			"FRANK",
-			font,
+			player_names[1],
+			sounds,
+			bubbles,
+			physics,
+			ropes,
 			2.f * winw / 3.f,
 			sf::Color {53, 152, 38},
 			avatar_tex,
@@ -763,58 +444,100 @@ int main(int argc, char* argv[])
 			aimbox_tex,
 			rope_tex
 		});
+		players[0]->prepare_laments(players[1]->get_name());
+		players[1]->prepare_laments(players[0]->get_name());
 
-		sf::Clock timer;
+		game_tick = 0;
 		game_time = 0.f;
 		float game_start_time = 0.f;
-		sf::Clock frame_timer;
-		unsigned int last_frame_time = 0;
 
 		sf::Text got;
 		got.setFont(font);
 		got.setCharacterSize(32);
 
-		float min_dist = 150.f;
-		float easy_dist = 350.f;
-		float hard_dist = 600.f;
-
-		std::list<Point*> points;
-		// starting points
-		points.push_back(new Point {1.f * winw / 3.f, winh - 400.f, point_tex});
-		points.push_back(new Point {2.f * winw / 3.f, winh - 400.f, point_tex});
-		// ladder
-		points.push_back(new Point {2.f * winw / 3.f + 80.f, winh - 500.f, point_tex});
-		points.push_back(new Point {2.f * winw / 3.f + 80.f, winh - 650.f, point_tex});
-		// long grapple
-		Point* long_grapple = new Point {2.f * winw / 3.f - 450.f, winh - 800.f, point_tex};
-		points.push_back(long_grapple);
-
-		// segue to normal gen
-		points.push_back(new Point {winw / 2.f - 300.f, winh - 1000.f, point_tex});
-		points.push_back(new Point {winw / 2.f - 150.f, winh - 1000.f, point_tex});
+		std::vector<Point*> points;
+		points.reserve(point_capacity);
+		float highest_point = 0.f;
+
+		// bring in the level's points up to a screen above the top of the view
+		auto stream_level = [&](float top)
+		{
+			while (const LevelPoint* authored = level.next(floor_y - top + winh))
+			{
+				Point* point = point_pool.make(authored->x, floor_y - authored->height, authored->flags & LEVEL_POINT_BOOST);
+				points.push_back(point);
+				if (point->pos().y < highest_point)
+					highest_point = point->pos().y;
+			}
+		};
+		stream_level(0.f);
+
+		// embers off the lava and sparks when someone dies
+		Particles embers {65536};
 
 		sf::RectangleShape bomb {sf::Vector2f{70.f, 30.f}};
 		bomb.setFillColor(sf::Color{180, 180, 180});
 
-		float highest_point = 0.f;
-		for (auto& point : points)
+		// called at the end of every frame
+		auto record_frame = [&](unsigned int sim_steps, uint8_t game_state)
 		{
-			if (point->pos().y < highest_point)
-				highest_point = point->pos().y;
-		}
+			TelemetryRecord record {};
+			record.frame = frame_count++;
+			record.frame_ms = sim.frame_time().asMicroseconds() / 1000.f;
+			record.game_time = game_time;
+			record.sim_steps = sim_steps;
+			record.points = points.size();
+			record.draw_calls = draw_calls;
+			record.game_state = game_state;
+			for (unsigned int i = 0; i < 2; ++i)
+			{
+				record.height[i] = floor_y - players[i]->pos().y;
+				record.lives[i] = players[i]->get_lives();
+				record.player_state[i] = players[i]->telemetry_state();
+			}
+			telemetry.write(record);
+			draw_calls = 0;
+			alloc_audit_frame(record.frame);
+		};
+
+		// everything in the world as the camera sees it, under the gui
+		auto draw_world = [&]()
+		{
+			render_target.setView(camera);
+			render_target.clear();
+			scene.draw_static(render_target, camera);
+			for (auto& player : players)
+				player->draw_rope_on(render_target);
+			for (auto& point : points)
+				point->draw_on(render_target);
+			preview.draw_on(render_target);
+			embers.draw_on(render_target);
+			for (auto& player : players)
+				player->draw_on(render_target, camera);
+			for (auto& player : players)
+				player->draw_target_on(render_target);
+		};
 
 		camera.zoom(0.5f);
 		camera.setCenter(winw / 2.f, winh / 2.f + 300.f);
+		scene.static_layers({&bg, &floor, &start});
 
 		bool running = true;
 		bool cutscene = true;
 		int cutphase = 0;
 		while (cutscene && running)
 		{
+			sim.start_frame();
+			// nothing to simulate yet, just let the clock run for speech
+			while (sim.tick())
+			{
+			}
+
 			// input
 			sf::Event event;
 			while (window.pollEvent(event))
 			{
+				sim.handle_event(event);
 				if (event.type == sf::Event::Closed || (event.type == sf::Event::KeyReleased && event.key.code == sf::Keyboard::Key::Escape))
 				{
 					running = false;
@@ -827,13 +550,13 @@ int main(int argc, char* argv[])
 			}
 			if (cutphase == 0 && sf::Joystick::isButtonPressed(0, 7) && sf::Joystick::isButtonPressed(1, 7))
 			{
-				players[0]->say("FRANK! THE FLOOR IS LAVA!", 2);
+				players[0]->say(intro_lines[0], 2);
 				cutphase = 1;
 			}
 
 			if (cutphase == 1 && !players[0]->is_speaking())
 			{
-				players[1]->say("GIUSEPPE! WHAT DO WE DO NOW?", 2);
+				players[1]->say(intro_lines[1], 2);
 				cutphase = 2;
 			}
 
@@ -843,15 +566,7 @@ int main(int argc, char* argv[])
 			}
 
 			// draw on render texture
-			render_target.setView(camera);
-			render_target.clear();
-			render_target.draw(bg);
-			render_target.draw(floor);
-			render_target.draw(start);
-			for (auto& point : points)
-				point->draw_on(render_target);
-			for (auto& player : players)
-				player->draw_on(render_target, camera);
+			draw_world();
 
 			// gui
 			render_target.setView(render_target.getDefaultView());
@@ -861,34 +576,35 @@ int main(int argc, char* argv[])
 			fx.setParameter("time", game_time);
 
 			window.clear();
-			window.draw(sf::Sprite {render_target.getTexture()}, &fx);
+			draw(window, sf::Sprite {render_target.getTexture()}, &fx);
+			capture.grab(window);
 			window.display();
 
-			last_frame_time += frame_timer.getElapsedTime().asMilliseconds();
-			frame_timer.restart();
-			game_time = timer.getElapsedTime().asSeconds();
+			record_frame(0, TELEMETRY_INTRO | TELEMETRY_CUTSCENE);
 		}
 
 		// transition to normal camera
+		bool zoomed = false;
+		scene.static_layers({&bg, &floor, &inst, &start});
 		while (running)
 		{
-			float zdiff = render_target.getDefaultView().getSize().x / camera.getSize().x;
-			if (zdiff < 1.01f)
+			sim.start_frame();
+			while (!zoomed && sim.tick())
+			{
+				float zdiff = render_target.getDefaultView().getSize().x / camera.getSize().x;
+				if (zdiff < 1.01f)
+				{
+					zoomed = true;
+					break;
+				}
+				camera.zoom((zdiff - 1.f) / 2.f + 1.f);
+				camera.move((render_target.getDefaultView().getCenter() - camera.getCenter()) / 3.f);
+			}
+			if (zoomed)
 				break;
-			camera.zoom((zdiff - 1.f) / 2.f + 1.f);
-			camera.move((render_target.getDefaultView().getCenter() - camera.getCenter()) / 3.f);
 
 			// draw on render texture
-			render_target.setView(camera);
-			render_target.clear();
-			render_target.draw(bg);
-			render_target.draw(floor);
-			render_target.draw(inst);
-			render_target.draw(start);
-			for (auto& point : points)
-				point->draw_on(render_target);
-			for (auto& player : players)
-				player->draw_on(render_target, camera);
+			draw_world();
 
 			// gui
 			render_target.setView(render_target.getDefaultView());
@@ -898,21 +614,24 @@ int main(int argc, char* argv[])
 			fx.setParameter("time", game_time);
 
 			window.clear();
-			window.draw(sf::Sprite {render_target.getTexture()}, &fx);
+			draw(window, sf::Sprite {render_target.getTexture()}, &fx);
+			capture.grab(window);
 			window.display();
 
-			last_frame_time += frame_timer.getElapsedTime().asMilliseconds();
-			frame_timer.restart();
-			game_time = timer.getElapsedTime().asSeconds();
+			record_frame(0, TELEMETRY_INTRO | TELEMETRY_CUTSCENE);
 		}
 		camera = render_target.getDefaultView();
+		scene.static_layers({&bg, &floor, &start, &inst, &snap});
 
 		while (running)
 		{
+			sim.start_frame();
+
 			// input
 			sf::Event event;
 			while (window.pollEvent(event))
 			{
+				sim.handle_event(event);
 				if (event.type == sf::Event::Closed || (event.type == sf::Event::KeyReleased && event.key.code == sf::Keyboard::Key::Escape))
 				{
 					running = false;
@@ -936,179 +655,167 @@ int main(int argc, char* argv[])
 				{
 					running = false;
 				}
+				if (event.type == sf::Event::KeyReleased && event.key.code == sf::Keyboard::Key::F8)
+					write_trace(trace_path);
+				if (event.type == sf::Event::KeyReleased && event.key.code == sf::Keyboard::Key::P)
+				{
+					preview.enabled = !preview.enabled;
+					preview.reset();
+				}
 			}
 
 			if (!gameover)
 			{
+				TraceSpan span {"aim"};
 				for (unsigned int i = 0; i < players.size(); ++i)
 				{
 					sf::Vector2f aim {sf::Joystick::getAxisPosition(i, sf::Joystick::Axis::X), sf::Joystick::getAxisPosition(i, sf::Joystick::Axis::Y)};
 					// deadzone check
 					if (norm(aim) > 50.f)
-						players[i]->aim(aim, players, points, camera);
+						players[i]->aim(aim, players, points, point_pool.version(), camera);
 					else
 						players[i]->stop_aim();
 				}
 			}
 
-			float bottom = camera.getCenter().y + camera.getSize().y / 2.f;
-
-			// remove points that are off the bottom
-			for (auto it = points.begin(); it != points.end();)
+			// game step
+			unsigned int sim_steps = 0;
+			while (sim.tick())
 			{
-				if ((*it)->pos().y > bottom)
-				{
-					for (auto& player : players)
-					{
-						if (player->target() == *it)
-							player->let_go();
-					}
-					it = points.erase(it);
-				}
-				else
-					++it;
-			}
+				TraceSpan tick_span {"tick"};
+				++sim_steps;
 
-			float top = camera.getCenter().y - camera.getSize().y / 2.f;
+				// before anything else this tick looks at where points are
+				move_points(points, game_tick);
 
-			if (top < bg.getPosition().y)
-			{
-				bg.move(0, -(int)bg_s.y * 4.f);
-			}
+				float bottom = camera.getCenter().y + camera.getSize().y / 2.f;
 
-			if (!gameover)
-			{
-				// kill players
-				for (auto& player : players)
+				// remove points that are off the bottom, and can't move back up
+				TraceSpan cull_span {"cull"};
+				for (auto it = points.begin(); it != points.end();)
 				{
-					if (player->is_dead() || player->is_reviving())
-						continue;
-
-					if (player->pos().y > bottom + 120.f || (!intro && player->pos().y >= winh - player->get_half_height()))
+					if ((*it)->get_anchor().y - (*it)->reach() > bottom)
 					{
-						player->die();
-
-						for (auto& ps : players)
+						for (auto& player : players)
 						{
-							if (ps->target() == player)
-								ps->let_go();
-							else if (ps != player && ps->is_grappling())
-							{
-								ps->lament(player->get_name());
-							}
-						}
-
-						if (player->get_lives() < 0)
-						{
-							if (!gameover)
-							{
-								gameover = true;
-								std::stringstream s;
-								s << "GAME OVER. SCORE: " << (render_target.getDefaultView().getCenter().y - camera.getCenter().y) << ". PRESS Y TO RESTART";
-								got.setString(s.str());
-								auto bounds = got.getLocalBounds();
-								got.setOrigin(bounds.width / 2.f, bounds.height / 2.f);
-								got.setPosition(winw / 2.f, winh / 2.f);
-							}
-							continue;
+							if (player->target() == *it)
+								player->let_go();
 						}
-
+						point_pool.release(*it);
+						it = points.erase(it);
 					}
+					else
+						++it;
 				}
+				cull_span.end();
 
-				// revive players
-				for (auto& player : players)
+				float top = camera.getCenter().y - camera.getSize().y / 2.f;
+
+				if (top < bg.getPosition().y)
 				{
-					if (!player->need_revive())
-						continue;
+					bg.move(0, -(int)bg_s.y * 4.f);
+				}
 
-					for (auto it = points.rbegin(); it != points.rend(); ++it)
+				if (!gameover)
+				{
+					// kill players
+					for (auto& player : players)
 					{
-						if ((*it)->pos().y > top)
+						if (player->is_dead() || player->is_reviving())
+							continue;
+
+						if (player->pos().y > bottom + 120.f || (!intro && player->pos().y >= floor_y - player->get_half_height()))
 						{
-							bool good = true;
-							for (auto& pl : players)
+							player->die();
+							// they usually die below the screen, so splash up from the lava
+							embers.burst(sf::Vector2f {player->pos().x, std::min(player->pos().y, bottom)}, 600);
+
+							for (auto& ps : players)
 							{
-								if (pl->target() == *it)
+								if (ps->target() == player)
+									ps->let_go();
+								else if (ps != player && ps->is_grappling())
 								{
-									good = false;
-									break;
+									ps->lament(player->get_name());
 								}
 							}
-							if (good)
+
+							if (player->get_lives() < 0)
 							{
-								player->target(*it);
-								player->revive();
-								break;
+								if (!gameover)
+								{
+									gameover = true;
+									char s[64];
+									std::snprintf(s, sizeof(s), "GAME OVER. SCORE: %g. PRESS Y TO RESTART", render_target.getDefaultView().getCenter().y - camera.getCenter().y + origin_offset);
+									got.setString(s);
+									auto bounds = got.getLocalBounds();
+									got.setOrigin(bounds.width / 2.f, bounds.height / 2.f);
+									got.setPosition(winw / 2.f, winh / 2.f);
+								}
+								continue;
 							}
+
 						}
 					}
-				}
 
-				for (auto& player : players)
-					if (player->target() == (Grappable*)long_grapple)
-						camera_speed_boost = -0.015f;
-			}
-
-			// generate level if the highest point is on the screen
-			if (!intro && highest_point > top)
-			{
-				float last_highest = highest_point;
-				int last_size = points.size();
-				// generate 1-4 more points
-				unsigned int new_points = randm(3) + 2;
-
-				while (points.size() - last_size < new_points)
-				{
-					for (auto& point : points)
+					// revive players
+					for (auto& player : players)
 					{
-						// random angle
-						int side = randm(2);
-						float theta = (randmf() + 1.f) * M_PI / 9.f;
-						if (side)
-							theta = -theta;
-						else
-							theta = theta - M_PI;
-
-						int difficulty = (randm(2) == 0 ? easy_dist : hard_dist);
-
-						sf::Vector2f p {point->pos().x + cosf(theta) * difficulty, point->pos().y + sinf(theta) * difficulty};
+						if (!player->need_revive())
+							continue;
 
-						// want it in bounds and at least one point higher than the previous
-						// XXX copied from Swinger class
-						if (p.y < last_highest && p.x > 200.f && p.x < winw - 200.f)
+						for (auto it = points.rbegin(); it != points.rend(); ++it)
 						{
-							// make sure it isn't too close to other points
-							bool bad = false;
-							for (auto& ps : points)
+							if ((*it)->pos().y > top)
 							{
-								if (dist2(ps->pos(), p) < min_dist * min_dist)
+								bool good = true;
+								for (auto& pl : players)
 								{
-									bad = true;
-									break;
+									if (pl->target() == *it)
+									{
+										good = false;
+										break;
+									}
 								}
-							}
-							if (!bad)
-							{
-								points.push_back(new Point {p.x, p.y, point_tex});
-
-								if (p.y < highest_point)
+								if (good)
 								{
-									highest_point = p.y;
+									player->target(*it);
+									player->revive();
+									break;
 								}
-								// need to break because iterator is invalid now
-								break;
 							}
 						}
 					}
+
+					for (auto& point : points)
+					{
+						if (!point->is_boost())
+							continue;
+						for (auto& player : players)
+							if (player->target() == point)
+								camera_speed_boost = -0.015f;
+					}
 				}
-			}
 
-			// game step
-			while (game_step > 0 && last_frame_time > game_step)
-			{
+				stream_level(top);
+
+				// generate level if the highest point is on the screen and the authored ones have run out
+				if (!intro && level.done() && level.endless() && !points.empty() && highest_point > top)
+				{
+					TraceSpan span {"generate"};
+					generate_points(points, point_pool, highest_point);
+				}
+
+				for (auto& player : players)
+					player->prepare_step();
+				physics.step(gravity, game_step, floor_y, winw);
 				for (auto& player : players)
-					player->step();
+					player->finish_step();
+				ropes.step(gravity, game_step);
+
+				if (!intro)
+					embers.embers(0.f, winw, bottom, 2);
+				embers.step(game_step);
 
 				if (intro)
 				{
@@ -1128,6 +835,7 @@ int main(int argc, char* argv[])
 						if (have_music)
 							music.play();
 						fx.setParameter("start_time", game_start_time);
+						darken.setParameter("start_time", game_start_time);
 					}
 				}
 				if (!intro)
@@ -1136,60 +844,113 @@ int main(int argc, char* argv[])
 					camera.move(0, camera_speed * game_step);
 				}
 
-				last_frame_time -= game_step;
+				if (spectate.begin(game_tick, camera.getCenter(), origin_offset))
+				{
+					for (auto& player : players)
+						spectate.player(player->pos(), player->target() ? player->target()->id() : 0, player->get_lives(), player->telemetry_state());
+					for (auto& point : points)
+						spectate.point(point->id(), point->pos(), point->moves());
+					spectate.send();
+				}
 			}
 
-			// draw on render texture
-			render_target.setView(camera);
-			render_target.clear();
-			render_target.draw(bg);
-			render_target.draw(floor);
+			// keep coordinates near the origin so float precision doesn't degrade on long runs
+			if (camera.getCenter().y < -rebase_tiles * bg_tile)
+			{
+				// shift by whole background tiles so the pattern lines up
+				float shift = std::floor(-camera.getCenter().y / bg_tile) * bg_tile;
+
+				camera.move(0, shift);
+				bg.move(0, shift);
+				floor.move(0, shift);
+				start.move(0, shift);
+				inst.move(0, shift);
+				snap.move(0, shift);
+				for (auto& point : points)
+					point->rebase(shift);
+				for (auto& player : players)
+					player->rebase(shift);
+				ropes.rebase(shift);
+				preview.rebase(shift);
+				embers.rebase(shift);
+				highest_point += shift;
+				floor_y += shift;
+				origin_offset += shift;
+			}
 
-			render_target.draw(start);
-			render_target.draw(inst);
-			render_target.draw(snap);
+			if (preview.enabled)
+			{
+				TraceSpan span {"preview"};
+				preview.update(players, points, camera.getCenter().y + camera.getSize().y / 2.f);
+			}
 
-			for (auto& player : players)
-				player->draw_rope_on(render_target);
-			for (auto& point : points)
-				point->draw_on(render_target);
-			for (auto& player : players)
-				player->draw_on(render_target, camera);
-			for (auto& player : players)
-				player->draw_target_on(render_target);
+			// draw on render texture
+			TraceSpan world_span {"draw-world"};
+			draw_world();
+			world_span.end();
 
 			// gui
+			TraceSpan gui_span {"draw-gui"};
 			render_target.setView(render_target.getDefaultView());
 			if (gameover)
 			{
-				render_target.draw(got);
+				draw(render_target, got);
 			}
 
 			for (auto& player : players)
 				player->draw_lives_on(render_target);
 
 			render_target.display();
+			gui_span.end();
 
 			// draw with full screen effects
+			TraceSpan fx_span {"post-fx"};
 			fx.setParameter("time", game_time);
 
 			window.clear();
-			window.draw(sf::Sprite {render_target.getTexture()}, &fx);
-			window.display();
+			if (intro)
+			{
+				draw(window, sf::Sprite {render_target.getTexture()}, &fx);
+			}
+			else
+			{
+				darken.setParameter("time", game_time);
+				draw(window, sf::Sprite {render_target.getTexture()}, &darken);
+				draw(window, lava, lava_states);
+			}
+			fx_span.end();
+			capture.grab(window);
+			{
+				TraceSpan span {"display"};
+				window.display();
+			}
+
+			sounds.update();
 
-			last_frame_time += frame_timer.getElapsedTime().asMilliseconds();
-			frame_timer.restart();
-			game_time = timer.getElapsedTime().asSeconds();
+			record_frame(sim_steps, (intro ? TELEMETRY_INTRO : 0) | (gameover ? TELEMETRY_GAMEOVER : 0));
 		}
 
 		// cleanup
 		for (auto& player : players)
 			delete player;
 		for (auto& point : points)
-			delete point;
+			point_pool.release(point);
 
 		music.stop();
 	}
 
+	window.setActive();
+	capture.stop();
+	write_trace(trace_path);
+
+	sounds.report(std::cerr);
+	bubbles.report(std::cerr);
+	scene.report(std::cerr);
+	preview.report(std::cerr);
+	Swinger::report(std::cerr);
+	spectate.report(std::cerr);
+	capture.report(std::cerr);
+	alloc_audit_report(std::cerr);
+
 	return 0;
 }
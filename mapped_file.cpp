@@ -0,0 +1,144 @@
+#include "mapped_file.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+#ifdef _WIN32
+
+static bool map_file(const std::string& path, std::size_t size, bool write, void*& file_handle, void*& map_handle, void*& data_ptr, std::size_t& data_size)
+{
+	HANDLE file = CreateFileA(path.c_str(), write ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, write ? OPEN_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	if (!write)
+	{
+		LARGE_INTEGER file_size;
+		if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0)
+		{
+			CloseHandle(file);
+			return false;
+		}
+		size = (std::size_t)file_size.QuadPart;
+	}
+
+	HANDLE map = CreateFileMappingA(file, nullptr, write ? PAGE_READWRITE : PAGE_READONLY, (DWORD)((unsigned long long)size >> 32), (DWORD)(size & 0xffffffff), nullptr);
+	if (!map)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	void* view = MapViewOfFile(map, write ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, size);
+	if (!view)
+	{
+		CloseHandle(map);
+		CloseHandle(file);
+		return false;
+	}
+
+	file_handle = file;
+	map_handle = map;
+	data_ptr = view;
+	data_size = size;
+	return true;
+}
+
+bool MappedFile::open_read(const std::string& path)
+{
+	close();
+	return map_file(path, 0, false, file_handle, map_handle, data_ptr, data_size);
+}
+
+bool MappedFile::open_write(const std::string& path, std::size_t size)
+{
+	close();
+	return map_file(path, size, true, file_handle, map_handle, data_ptr, data_size);
+}
+
+void MappedFile::close()
+{
+	if (data_ptr)
+		UnmapViewOfFile(data_ptr);
+	if (map_handle)
+		CloseHandle(map_handle);
+	if (file_handle)
+		CloseHandle(file_handle);
+	data_ptr = nullptr;
+	map_handle = nullptr;
+	file_handle = nullptr;
+	data_size = 0;
+}
+
+#else
+
+bool MappedFile::open_read(const std::string& path)
+{
+	close();
+
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0)
+	{
+		::close(fd);
+		return false;
+	}
+
+	void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	// the mapping stays valid after the descriptor is closed
+	::close(fd);
+	if (p == MAP_FAILED)
+		return false;
+
+	data_ptr = p;
+	data_size = st.st_size;
+	return true;
+}
+
+bool MappedFile::open_write(const std::string& path, std::size_t size)
+{
+	close();
+
+	int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+	if (fd < 0)
+		return false;
+
+	if (ftruncate(fd, size) != 0)
+	{
+		::close(fd);
+		return false;
+	}
+
+	void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (p == MAP_FAILED)
+		return false;
+
+	data_ptr = p;
+	data_size = size;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (data_ptr)
+		munmap(data_ptr, data_size);
+	data_ptr = nullptr;
+	data_size = 0;
+}
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <string>
+
+// a file mapped into memory, either read-only or shared read-write
+class MappedFile
+{
+	void* data_ptr = nullptr;
+	std::size_t data_size = 0;
+#ifdef _WIN32
+	void* file_handle = nullptr;
+	void* map_handle = nullptr;
+#endif
+public:
+	MappedFile() = default;
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	~MappedFile();
+
+	// map an existing file for reading
+	bool open_read(const std::string& path);
+	// create (or resize) a file and map it for writing, changes go straight to the page cache
+	bool open_write(const std::string& path, std::size_t size);
+	void close();
+
+	inline bool is_open() const
+	{
+		return data_ptr != nullptr;
+	}
+
+	inline void* data() const
+	{
+		return data_ptr;
+	}
+
+	inline std::size_t size() const
+	{
+		return data_size;
+	}
+};
+
+#endif
@@ -0,0 +1,144 @@
+#define _USE_MATH_DEFINES
+#include <cmath>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "draw.hpp"
+#include "particles.hpp"
+
+Particles::Particles(std::size_t cap)
+	: capacity {cap}, vertices {sf::Quads}
+{
+	// round up so the SIMD loop never needs a bounds check
+	std::size_t padded = (cap + 3) & ~(std::size_t)3;
+	x.resize(padded);
+	y.resize(padded);
+	vx.resize(padded);
+	vy.resize(padded);
+	life.resize(padded);
+	decay.resize(padded);
+}
+
+float Particles::rand01()
+{
+	// xorshift32, cheap and doesn't touch the game's rand()
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	return (seed >> 8) / 16777216.f;
+}
+
+void Particles::emit(float px, float py, float pvx, float pvy, float lifetime_ms)
+{
+	if (count == capacity)
+		return;
+
+	x[count] = px;
+	y[count] = py;
+	vx[count] = pvx;
+	vy[count] = pvy;
+	life[count] = 1.f;
+	decay[count] = 1.f / lifetime_ms;
+	++count;
+}
+
+void Particles::embers(float left, float right, float line, unsigned int n)
+{
+	for (unsigned int i = 0; i < n; ++i)
+	{
+		emit(left + rand01() * (right - left), line, (rand01() - 0.5f) * 0.05f, -0.05f - rand01() * 0.15f, 1000.f + rand01() * 1500.f);
+	}
+}
+
+void Particles::burst(const sf::Vector2f& pos, unsigned int n)
+{
+	for (unsigned int i = 0; i < n; ++i)
+	{
+		float theta = rand01() * 2.f * M_PI;
+		float speed = 0.05f + rand01() * 0.4f;
+		emit(pos.x, pos.y, cosf(theta) * speed, sinf(theta) * speed, 400.f + rand01() * 800.f);
+	}
+}
+
+void Particles::step(float dt)
+{
+	float damp = powf(drag, dt);
+	float ax = buoyancy.x * dt;
+	float ay = buoyancy.y * dt;
+
+	std::size_t i = 0;
+#ifdef __SSE2__
+	__m128 v_dt = _mm_set1_ps(dt);
+	__m128 v_damp = _mm_set1_ps(damp);
+	__m128 v_ax = _mm_set1_ps(ax);
+	__m128 v_ay = _mm_set1_ps(ay);
+	for (; i < count; i += 4)
+	{
+		__m128 pvx = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&vx[i]), v_damp), v_ax);
+		__m128 pvy = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&vy[i]), v_damp), v_ay);
+		_mm_storeu_ps(&vx[i], pvx);
+		_mm_storeu_ps(&vy[i], pvy);
+		_mm_storeu_ps(&x[i], _mm_add_ps(_mm_loadu_ps(&x[i]), _mm_mul_ps(pvx, v_dt)));
+		_mm_storeu_ps(&y[i], _mm_add_ps(_mm_loadu_ps(&y[i]), _mm_mul_ps(pvy, v_dt)));
+		_mm_storeu_ps(&life[i], _mm_sub_ps(_mm_loadu_ps(&life[i]), _mm_mul_ps(_mm_loadu_ps(&decay[i]), v_dt)));
+	}
+#else
+	for (; i < count; ++i)
+	{
+		vx[i] = vx[i] * damp + ax;
+		vy[i] = vy[i] * damp + ay;
+		x[i] += vx[i] * dt;
+		y[i] += vy[i] * dt;
+		life[i] -= decay[i] * dt;
+	}
+#endif
+
+	// swap dead particles out of the live range
+	for (i = 0; i < count;)
+	{
+		if (life[i] > 0.f)
+		{
+			++i;
+			continue;
+		}
+		--count;
+		x[i] = x[count];
+		y[i] = y[count];
+		vx[i] = vx[count];
+		vy[i] = vy[count];
+		life[i] = life[count];
+		decay[i] = decay[count];
+	}
+}
+
+void Particles::rebase(float dy)
+{
+	for (std::size_t i = 0; i < count; ++i)
+		y[i] += dy;
+}
+
+void Particles::draw_on(sf::RenderTarget& render_target)
+{
+	if (count == 0)
+		return;
+
+	vertices.resize(count * 4);
+	float h = size / 2.f;
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		// yellow when fresh, fading to dark red
+		float l = life[i];
+		sf::Color color {255, (sf::Uint8)(60 + 180 * l * l), (sf::Uint8)(40 * l), (sf::Uint8)(255 * l)};
+
+		sf::Vertex* quad = &vertices[i * 4];
+		quad[0].position = sf::Vector2f {x[i] - h, y[i] - h};
+		quad[1].position = sf::Vector2f {x[i] + h, y[i] - h};
+		quad[2].position = sf::Vector2f {x[i] + h, y[i] + h};
+		quad[3].position = sf::Vector2f {x[i] - h, y[i] + h};
+		quad[0].color = quad[1].color = quad[2].color = quad[3].color = color;
+	}
+
+	draw(render_target, vertices);
+}
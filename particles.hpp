@@ -0,0 +1,60 @@
+#ifndef PARTICLES_HPP
+#define PARTICLES_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+
+// Lava embers and sparks. Particles are kept packed in separate arrays per
+// field so the update runs four at a time with SSE, dead particles are
+// swapped out of the live range afterwards.
+class Particles
+{
+	std::size_t capacity;
+	std::size_t count = 0;
+
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<float> vx;
+	std::vector<float> vy;
+	// 1 when spawned, dead at 0
+	std::vector<float> life;
+	// life lost per ms
+	std::vector<float> decay;
+
+	sf::VertexArray vertices;
+
+	uint32_t seed = 2463534242u;
+
+	float rand01();
+public:
+	// acceleration in pixels/ms^2, embers float up
+	sf::Vector2f buoyancy {0.f, -0.00004f};
+	// fraction of velocity kept per ms
+	float drag = 0.999f;
+	float size = 3.f;
+
+	explicit Particles(std::size_t cap);
+
+	inline std::size_t size_alive() const
+	{
+		return count;
+	}
+
+	void emit(float px, float py, float pvx, float pvy, float lifetime_ms);
+
+	// n embers rising from a horizontal line
+	void embers(float left, float right, float line, unsigned int n);
+	// n sparks flying out of a point
+	void burst(const sf::Vector2f& pos, unsigned int n);
+
+	// advance dt milliseconds
+	void step(float dt);
+
+	void rebase(float dy);
+
+	void draw_on(sf::RenderTarget& render_target);
+};
+
+#endif
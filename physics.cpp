@@ -0,0 +1,191 @@
+#include <algorithm>
+#include <cstring>
+
+#include "physics.hpp"
+#include "sim_math.hpp"
+
+void SwingerPhysics::reserve(unsigned int n)
+{
+	px.reserve(n);
+	py.reserve(n);
+	vx.reserve(n);
+	vy.reserve(n);
+	swing_vel.reserve(n);
+	grap_dist.reserve(n);
+	tx.reserve(n);
+	ty.reserve(n);
+	half_width.reserve(n);
+	half_height.reserve(n);
+	grappling.reserve(n);
+	active.reserve(n);
+	events.reserve(n);
+}
+
+unsigned int SwingerPhysics::add(float x, float y, float hw, float hh)
+{
+	px.push_back(x);
+	py.push_back(y);
+	vx.push_back(0.f);
+	vy.push_back(0.f);
+	swing_vel.push_back(0.f);
+	grap_dist.push_back(0.f);
+	tx.push_back(0.f);
+	ty.push_back(0.f);
+	half_width.push_back(hw);
+	half_height.push_back(hh);
+	grappling.push_back(GRAPPLE_NONE);
+	active.push_back(1);
+	events.push_back(0);
+	return px.size() - 1;
+}
+
+// Each pass below runs over every body and keeps or discards its result with
+// a bitwise select instead of a branch, so the loops vectorize. Plain ?: on
+// floats gets turned back into jumps and conditional stores by the optimizer.
+// The passes are free functions because compilers only trust __restrict on
+// parameters.
+
+static inline uint32_t mask(bool c)
+{
+	return -(uint32_t)c;
+}
+
+// a where m is set, b elsewhere
+static inline float select(uint32_t m, float a, float b)
+{
+	uint32_t ia, ib;
+	std::memcpy(&ia, &a, sizeof ia);
+	std::memcpy(&ib, &b, sizeof ib);
+	uint32_t r = (ia & m) | (ib & ~m);
+	float f;
+	std::memcpy(&f, &r, sizeof f);
+	return f;
+}
+
+static void fall(unsigned int n, float* __restrict x, float* __restrict y, float* __restrict u, float* __restrict v,
+	const float* __restrict hw, const float* __restrict hh, const uint8_t* __restrict state, const uint8_t* __restrict alive,
+	float gx, float gy, float dt, float floor, float width)
+{
+	for (unsigned int i = 0; i < n; ++i)
+	{
+		uint32_t falling = mask(alive[i] & (state[i] == GRAPPLE_NONE));
+
+		float nu = u[i] + gx * dt;
+		float nv = v[i] + gy * dt;
+		float nx = x[i] + nu * dt;
+		float ny = y[i] + nv * dt;
+
+		// bounce off the walls
+		float right_wall = width - hh[i];
+		uint32_t right = mask(nx > right_wall);
+		uint32_t left = mask(nx < hw[i]) & ~right;
+		nx = select(right, right_wall, select(left, hw[i], nx));
+		nu = select(right | left, nu / -2.f, nu);
+
+		// don't fall through floor
+		float floor_y = floor - hh[i];
+		uint32_t landed = mask(ny > floor_y);
+		nu = select(landed, 0.f, nu);
+		nv = select(landed, 0.f, nv);
+		ny = select(landed, floor_y, ny);
+
+		u[i] = select(falling, nu, u[i]);
+		v[i] = select(falling, nv, v[i]);
+		x[i] = select(falling, nx, x[i]);
+		y[i] = select(falling, ny, y[i]);
+	}
+}
+
+static void pull(unsigned int n, float* __restrict x, float* __restrict y, float* __restrict u, float* __restrict v,
+	float* __restrict sv, float* __restrict gd, const float* __restrict tx, const float* __restrict ty,
+	uint8_t* __restrict state, const uint8_t* __restrict alive, uint8_t* __restrict ev,
+	float max_dist, float speed_factor, float min_speed, float start_swing, float dt)
+{
+	const float max_dist2 = max_dist * max_dist;
+
+	for (unsigned int i = 0; i < n; ++i)
+	{
+		uint32_t grappled = mask(alive[i] & (state[i] != GRAPPLE_NONE));
+
+		float dx = tx[i] - x[i];
+		float dy = ty[i] - y[i];
+		float d2 = dx * dx + dy * dy;
+		uint32_t far = mask(d2 > max_dist2);
+		uint32_t pulling = grappled & far;
+
+		// pull speed proportional to distance, until you're close
+		float speed = SimMath::sqrt(select(pulling, d2 - max_dist2, 0.f)) * speed_factor;
+		speed = std::max(speed, min_speed);
+		float d = SimMath::sqrt(d2);
+		float safe_d = select(mask(d > 0.f), d, 1.f);
+		float nu = dx / safe_d * speed;
+		float nv = dy / safe_d * speed;
+
+		u[i] = select(pulling, nu, u[i]);
+		v[i] = select(pulling, nv, v[i]);
+		x[i] = select(pulling, x[i] + nu * dt, x[i]);
+		y[i] = select(pulling, y[i] + nv * dt, y[i]);
+
+		// if we're close enough, start swinging
+		uint32_t latching = grappled & ~far & mask(state[i] == GRAPPLE_PULLING);
+		float side = select(mask(x[i] < tx[i]), 1.f, -1.f);
+		float start_vel = side * ((y[i] - ty[i]) + d) * start_swing / 2.f;
+		gd[i] = select(latching, d, gd[i]);
+		sv[i] = select(latching, start_vel, sv[i]);
+		// GRAPPLE_PULLING + 1 == GRAPPLE_SWINGING
+		state[i] += latching & 1;
+		ev[i] = latching & BODY_STARTED_SWINGING;
+	}
+}
+
+static void swing(unsigned int n, float* __restrict x, float* __restrict y, float* __restrict u, float* __restrict v,
+	float* __restrict sv, const float* __restrict gd, const float* __restrict tx, const float* __restrict ty,
+	const uint8_t* __restrict state, const uint8_t* __restrict alive,
+	float gx, float gy, float dt)
+{
+	for (unsigned int i = 0; i < n; ++i)
+	{
+		uint32_t swinging = mask(alive[i] & (state[i] == GRAPPLE_SWINGING));
+
+		// normalized tangent of swing direction
+		float rx = x[i] - tx[i];
+		float ry = y[i] - ty[i];
+		float r = SimMath::sqrt(rx * rx + ry * ry);
+		float safe_r = select(mask(r > 0.f), r, 1.f);
+		float perp_x = ry / safe_r;
+		float perp_y = -rx / safe_r;
+
+		// naive velocity/position update
+		float nsv = sv[i] + (gx * perp_x + gy * perp_y) * dt;
+		float nu = perp_x * nsv;
+		float nv = perp_y * nsv;
+		float nx = x[i] + nu * dt;
+		float ny = y[i] + nv * dt;
+
+		// force position into grapple distance
+		float ex = nx - tx[i];
+		float ey = ny - ty[i];
+		float e = SimMath::sqrt(ex * ex + ey * ey);
+		float k = gd[i] / select(mask(e > 0.f), e, 1.f);
+		nx = tx[i] + ex * k;
+		ny = ty[i] + ey * k;
+
+		sv[i] = select(swinging, nsv, sv[i]);
+		u[i] = select(swinging, nu, u[i]);
+		v[i] = select(swinging, nv, v[i]);
+		x[i] = select(swinging, nx, x[i]);
+		y[i] = select(swinging, ny, y[i]);
+	}
+}
+
+void SwingerPhysics::step(const sf::Vector2f& gravity, float dt, float floor, float width)
+{
+	const unsigned int n = size();
+
+	fall(n, px.data(), py.data(), vx.data(), vy.data(), half_width.data(), half_height.data(),
+		grappling.data(), active.data(), gravity.x, gravity.y, dt, floor, width);
+	pull(n, px.data(), py.data(), vx.data(), vy.data(), swing_vel.data(), grap_dist.data(), tx.data(), ty.data(),
+		grappling.data(), active.data(), events.data(), max_grap_dist, pull_speed_factor, min_pull_speed, starting_swing_vel, dt);
+	swing(n, px.data(), py.data(), vx.data(), vy.data(), swing_vel.data(), grap_dist.data(), tx.data(), ty.data(),
+		grappling.data(), active.data(), gravity.x, gravity.y, dt);
+}
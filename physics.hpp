@@ -0,0 +1,66 @@
+#ifndef PHYSICS_HPP
+#define PHYSICS_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include <SFML/System.hpp>
+
+// grappling states
+enum : uint8_t
+{
+	GRAPPLE_NONE = 0,
+	// moving toward the target
+	GRAPPLE_PULLING = 1,
+	GRAPPLE_SWINGING = 2,
+};
+
+// things that happened to a body during step()
+enum : uint8_t
+{
+	BODY_STARTED_SWINGING = 1,
+};
+
+// Physics state of every swinger packed field by field, so a tick is a few
+// tight loops over arrays instead of a call per swinger. Sprites, text and
+// game rules stay in Swinger, which refers to its body by index.
+class SwingerPhysics
+{
+public:
+	std::vector<float> px;
+	std::vector<float> py;
+	std::vector<float> vx;
+	std::vector<float> vy;
+	// velocity in the reference frame of swinging
+	std::vector<float> swing_vel;
+	std::vector<float> grap_dist;
+	// where each grapple target is this tick, filled in before step()
+	std::vector<float> tx;
+	std::vector<float> ty;
+	std::vector<float> half_width;
+	std::vector<float> half_height;
+	std::vector<uint8_t> grappling;
+	// dead bodies don't move
+	std::vector<uint8_t> active;
+	std::vector<uint8_t> events;
+
+	float max_grap_dist = 200.f;
+	float pull_speed_factor = 0.004f;
+	float min_pull_speed = 0.04f;
+	float starting_swing_vel = 0.004f;
+
+	inline unsigned int size() const
+	{
+		return px.size();
+	}
+
+	void reserve(unsigned int n);
+
+	// returns the new body's index
+	unsigned int add(float x, float y, float hw, float hh);
+
+	// advance every body dt ms, bouncing off the walls at 0 and width and landing on floor
+	void step(const sf::Vector2f& gravity, float dt, float floor, float width);
+};
+
+#endif
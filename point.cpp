@@ -0,0 +1,97 @@
+#define _USE_MATH_DEFINES
+#include <cmath>
+
+#include "game.hpp"
+#include "point.hpp"
+#include "sim_math.hpp"
+
+PointPool::PointPool(const sf::Texture& tex, unsigned int capacity)
+	: texture {tex}
+{
+	free.reserve(capacity);
+	for (unsigned int i = 0; i < capacity; ++i)
+		free.push_back(new Point {0.f, 0.f, texture});
+}
+
+PointPool::~PointPool()
+{
+	for (auto& point : free)
+		delete point;
+}
+
+Point* PointPool::make(float x, float y, bool boost, const PointMotion& motion)
+{
+	Point* point;
+	if (free.empty())
+	{
+		point = new Point {x, y, texture};
+	}
+	else
+	{
+		point = free.back();
+		free.pop_back();
+	}
+	point->reset(next_id++, x, y, boost, motion);
+	++changes;
+	return point;
+}
+
+float PointMotion::reach() const
+{
+	if (kind == MOTION_NONE)
+		return 0.f;
+	if (kind == MOTION_CIRCLE)
+		return extent.x;
+	return SimMath::sqrt(extent.x * extent.x + extent.y * extent.y);
+}
+
+// offset from the anchor `time` ms in, and the velocity there
+static sf::Vector2f motion_offset(const PointMotion& m, float time, sf::Vector2f& velocity)
+{
+	float a = m.rate * time + m.phase;
+	// where along the path, -1 to 1 for back and forth, and its rate of change
+	float along;
+	float speed;
+	if (m.kind == MOTION_LINEAR)
+	{
+		// a triangle wave with the same period as sin
+		float f = a / (2.f * M_PI);
+		f -= std::floor(f);
+		along = f < 0.25f ? 4.f * f : f < 0.75f ? 2.f - 4.f * f : 4.f * f - 4.f;
+		speed = (f < 0.25f || f >= 0.75f ? 2.f : -2.f) / M_PI;
+	}
+	else
+	{
+		along = SimMath::sin(a);
+		speed = SimMath::cos(a);
+	}
+
+	if (m.kind == MOTION_CIRCLE)
+	{
+		velocity = sf::Vector2f {-along, speed} * (m.extent.x * m.rate);
+		return sf::Vector2f {speed, along} * m.extent.x;
+	}
+	velocity = m.extent * (speed * m.rate);
+	return m.extent * along;
+}
+
+sf::Vector2f Point::position_at(unsigned int tick) const
+{
+	if (motion.kind == MOTION_NONE)
+		return position;
+	sf::Vector2f unused;
+	return anchor + motion_offset(motion, (float)tick * game_step, unused);
+}
+
+void move_points(const std::vector<Point*>& points, unsigned int tick)
+{
+	float time = (float)tick * game_step;
+	for (auto& point : points)
+	{
+		if (point->motion.kind == MOTION_NONE)
+			continue;
+
+		point->position = point->anchor + motion_offset(point->motion, time, point->velocity);
+		point->sprite.setPosition(point->position);
+	}
+}
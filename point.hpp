@@ -0,0 +1,177 @@
+#ifndef POINT_HPP
+#define POINT_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+
+#include "draw.hpp"
+
+// anything a swinger can grapple onto
+class Grappable
+{
+protected:
+	sf::Vector2f position;
+	sf::Vector2f velocity;
+	// stable across frames, what spectators know it by
+	uint32_t grappable_id = 0;
+public:
+	Grappable(float x, float y)
+		: position {x, y}, velocity {0.f, 0.f}
+	{}
+
+	Grappable(const sf::Vector2f& v)
+		: position {v}
+	{}
+
+	inline const sf::Vector2f& pos() const
+	{
+		return position;
+	}
+
+	inline const sf::Vector2f& vel() const
+	{
+		return velocity;
+	}
+
+	inline uint32_t id() const
+	{
+		return grappable_id;
+	}
+
+	// shift into a rebased coordinate frame
+	void rebase(float dy)
+	{
+		position.y += dy;
+	}
+};
+
+// ways a point can move around its anchor
+enum : uint8_t
+{
+	MOTION_NONE = 0,
+	// back and forth between anchor - extent and anchor + extent at a steady speed
+	MOTION_LINEAR = 1,
+	// the same, easing in and out at the ends
+	MOTION_SINE = 2,
+	// round a circle of radius extent.x
+	MOTION_CIRCLE = 3,
+};
+
+// Where a moving point is is a function of game time, not of the ticks
+// before, so it stays reproducible and any point can be placed on its own.
+struct PointMotion
+{
+	uint8_t kind = MOTION_NONE;
+	sf::Vector2f extent;
+	// radians per ms, a full cycle is 2 pi
+	float rate = 0.f;
+	float phase = 0.f;
+
+	// furthest the point gets from its anchor
+	float reach() const;
+};
+
+class Point : public Grappable
+{
+	sf::Sprite sprite;
+	// grappling it speeds up the camera
+	bool boost = false;
+	// where it moves around
+	sf::Vector2f anchor;
+	PointMotion motion;
+
+	friend void move_points(const std::vector<Point*>& points, unsigned int tick);
+public:
+	Point(float x, float y, const sf::Texture& texture)
+		: Grappable {x, y}, sprite {texture}, anchor {x, y}
+	{
+		auto s = texture.getSize();
+		sprite.setOrigin(s.x / 2.f, s.y / 2.f);
+		sprite.setScale(4.f, 4.f);
+		sprite.setPosition(position);
+	}
+
+	// reuse as a new point
+	void reset(uint32_t new_id, float x, float y, bool boosts, const PointMotion& moves)
+	{
+		grappable_id = new_id;
+		position = sf::Vector2f {x, y};
+		velocity = sf::Vector2f {0.f, 0.f};
+		boost = boosts;
+		anchor = position;
+		motion = moves;
+		sprite.setPosition(position);
+	}
+
+	inline bool is_boost() const
+	{
+		return boost;
+	}
+
+	inline bool moves() const
+	{
+		return motion.kind != MOTION_NONE;
+	}
+
+	inline const sf::Vector2f& get_anchor() const
+	{
+		return anchor;
+	}
+
+	inline float reach() const
+	{
+		return motion.reach();
+	}
+
+	// where it is at the start of game tick `tick`, as move_points() would put it
+	sf::Vector2f position_at(unsigned int tick) const;
+
+	void rebase(float dy)
+	{
+		Grappable::rebase(dy);
+		anchor.y += dy;
+		sprite.setPosition(position);
+	}
+
+	void draw_on(sf::RenderTexture& render_target)
+	{
+		draw(render_target, sprite);
+	}
+};
+
+// recycles points so generating the level doesn't allocate
+class PointPool
+{
+	const sf::Texture& texture;
+	std::vector<Point*> free;
+	// every point made gets a new id, counting up
+	uint32_t next_id = 1;
+	uint32_t changes = 0;
+public:
+	PointPool(const sf::Texture& tex, unsigned int capacity);
+	PointPool(const PointPool&) = delete;
+	PointPool& operator=(const PointPool&) = delete;
+	~PointPool();
+
+	Point* make(float x, float y, bool boost = false, const PointMotion& motion = PointMotion {});
+
+	inline void release(Point* point)
+	{
+		free.push_back(point);
+		++changes;
+	}
+
+	// changes whenever a point is made or released, so a scan of the points can be reused until it does
+	inline uint32_t version() const
+	{
+		return changes;
+	}
+};
+
+// put every moving point where it is at the start of game tick `tick`, in one
+// pass; motion rates are per ms, ticks are game_step ms
+void move_points(const std::vector<Point*>& points, unsigned int tick);
+
+#endif
@@ -0,0 +1,257 @@
+#include <algorithm>
+
+#include "draw.hpp"
+#include "game.hpp"
+#include "preview.hpp"
+
+const unsigned int TrajectoryPreview::max_players;
+const unsigned int TrajectoryPreview::max_steps;
+const unsigned int TrajectoryPreview::max_marks;
+
+TrajectoryPreview::TrajectoryPreview()
+{
+	flight.reserve(max_players);
+	// one body per player, still until there's an arc to fly
+	for (unsigned int i = 0; i < max_players; ++i)
+		flight.active[flight.add(0.f, 0.f, 0.f, 0.f)] = 0;
+
+	ring.setRadius(28.f);
+	ring.setOrigin(28.f, 28.f);
+	ring.setFillColor(sf::Color::Transparent);
+	ring.setOutlineThickness(4.f);
+}
+
+void TrajectoryPreview::reset()
+{
+	for (unsigned int i = 0; i < max_players; ++i)
+	{
+		arcs[i].active = false;
+		arcs[i].shown = false;
+		arcs[i].flying = false;
+		arcs[i].target = nullptr;
+		flight.active[i] = 0;
+	}
+	player_count = 0;
+}
+
+void TrajectoryPreview::start_pass(unsigned int i, const Swinger& player, const sf::Vector2f& velocity)
+{
+	Arc& arc = arcs[i];
+	arc.flying = true;
+	arc.next.origin = player.pos();
+	arc.next.velocity = velocity;
+	arc.next.tick = game_tick;
+	arc.next.moving = false;
+	arc.next.length = 0;
+	arc.next.mark_count = 0;
+
+	flight.px[i] = player.pos().x;
+	flight.py[i] = player.pos().y;
+	flight.vx[i] = velocity.x;
+	flight.vy[i] = velocity.y;
+	flight.half_width[i] = player.get_half_width();
+	flight.half_height[i] = player.get_half_height();
+	flight.grappling[i] = GRAPPLE_NONE;
+	flight.active[i] = 1;
+	++passes;
+}
+
+void TrajectoryPreview::finish_pass(unsigned int i)
+{
+	Arc& arc = arcs[i];
+	arc.done.origin = arc.next.origin;
+	arc.done.velocity = arc.next.velocity;
+	arc.done.tick = arc.next.tick;
+	arc.done.moving = arc.next.moving;
+	std::copy(arc.next.samples, arc.next.samples + arc.next.length, arc.done.samples);
+	arc.done.length = arc.next.length;
+	std::copy(arc.next.marks, arc.next.marks + arc.next.mark_count, arc.done.marks);
+	arc.done.mark_count = arc.next.mark_count;
+	arc.shown = true;
+	arc.flying = false;
+	flight.active[i] = 0;
+}
+
+void TrajectoryPreview::update(const std::vector<Swinger*>& players, const std::vector<Point*>& points, float bottom)
+{
+	if (!enabled)
+		return;
+
+	clock.restart();
+
+	unsigned int count = players.size() < max_players ? players.size() : max_players;
+	for (unsigned int i = count; i < player_count; ++i)
+	{
+		arcs[i].active = false;
+		flight.active[i] = 0;
+	}
+	player_count = count;
+
+	bool flying = false;
+	for (unsigned int i = 0; i < player_count; ++i)
+	{
+		Swinger* player = players[i];
+		Arc& arc = arcs[i];
+		bool grappling = !player->is_dead() && player->target();
+		// a new target is a new rope, nothing carries over
+		if (!grappling || player->target() != arc.target)
+		{
+			arc.shown = false;
+			arc.flying = false;
+			flight.active[i] = 0;
+		}
+		arc.active = grappling;
+		arc.target = player->target();
+		if (!grappling)
+			continue;
+
+		arc.reach = player->get_reach();
+		arc.reach2 = arc.reach * arc.reach;
+		arc.color = player->get_color();
+		arc.position = player->pos();
+
+		// what release() would leave the player with
+		sf::Vector2f velocity = player->vel() + player->target()->vel();
+		const Pass& done = arc.done;
+		bool drifted = !arc.shown || norm2(velocity - done.velocity) > velocity_drift * velocity_drift
+			|| dist2(arc.position, done.origin) > position_drift * position_drift
+			|| (done.moving && game_tick - done.tick > refly_ticks);
+		// the pass in flight is at most a few frames old, let it finish
+		if (drifted && !arc.flying)
+			start_pass(i, *player, velocity);
+		flying |= arc.flying;
+	}
+
+	for (unsigned int s = 0; s < budget && flying; ++s)
+	{
+		flight.step(gravity, game_step, floor_y, winw);
+		++steps;
+
+		flying = false;
+		for (unsigned int i = 0; i < player_count; ++i)
+		{
+			Arc& arc = arcs[i];
+			if (!arc.flying)
+				continue;
+
+			Pass& pass = arc.next;
+			sf::Vector2f p {flight.px[i], flight.py[i]};
+			pass.samples[pass.length++] = p;
+
+			for (auto& point : points)
+			{
+				if (point == arc.target)
+					continue;
+				sf::Vector2f at = point->pos();
+				if (point->moves())
+				{
+					float range = arc.reach + point->reach();
+					if (dist2(point->get_anchor(), p) > range * range)
+						continue;
+					pass.moving = true;
+					// where it is when the player gets here
+					at = point->position_at(pass.tick + pass.length);
+				}
+				if (pass.mark_count == max_marks || dist2(at, p) > arc.reach2)
+					continue;
+				bool marked = false;
+				for (unsigned int m = 0; m < pass.mark_count; ++m)
+					marked |= pass.marks[m].point == point;
+				if (!marked)
+					pass.marks[pass.mark_count++] = Mark {point, point->id(), pass.length - 1, true};
+			}
+
+			// landed, into the lava, or far enough
+			if (p.y > bottom || (flight.vx[i] == 0.f && flight.vy[i] == 0.f) || pass.length == max_steps)
+				finish_pass(i);
+			else
+				flying = true;
+		}
+	}
+
+	// letting go now reaches sample k at the start of tick game_tick + k + 1,
+	// not when the arc was flown, and moving points have gone on since
+	for (unsigned int i = 0; i < player_count; ++i)
+	{
+		Arc& arc = arcs[i];
+		if (!arc.active || !arc.shown)
+			continue;
+		Pass& done = arc.done;
+		sf::Vector2f offset = arc.position - done.origin;
+		for (unsigned int m = 0; m < done.mark_count; ++m)
+		{
+			Mark& mark = done.marks[m];
+			const Point* point = mark.point;
+			mark.near = point->id() == mark.id
+				&& (!point->moves() || dist2(point->position_at(game_tick + mark.sample + 1), done.samples[mark.sample] + offset) <= arc.reach2);
+		}
+	}
+
+	++updates;
+	sf::Int64 us = clock.getElapsedTime().asMicroseconds();
+	update_total += us;
+	if (us > update_max)
+		update_max = us;
+}
+
+void TrajectoryPreview::rebase(float dy)
+{
+	for (unsigned int i = 0; i < player_count; ++i)
+	{
+		Arc& arc = arcs[i];
+		arc.position.y += dy;
+		arc.done.origin.y += dy;
+		for (unsigned int k = 0; k < arc.done.length; ++k)
+			arc.done.samples[k].y += dy;
+		arc.next.origin.y += dy;
+		for (unsigned int k = 0; k < arc.next.length; ++k)
+			arc.next.samples[k].y += dy;
+		flight.py[i] += dy;
+	}
+}
+
+void TrajectoryPreview::draw_on(sf::RenderTarget& render_target)
+{
+	if (!enabled)
+		return;
+
+	for (unsigned int i = 0; i < player_count; ++i)
+	{
+		const Arc& arc = arcs[i];
+		const Pass& pass = arc.done;
+		if (!arc.active || !arc.shown || pass.length < 2)
+			continue;
+
+		// fading out along the way
+		strip.resize(pass.length);
+		for (unsigned int k = 0; k < pass.length; ++k)
+		{
+			sf::Color color = arc.color;
+			color.a = 200 - 200 * k / max_steps;
+			strip[k] = sf::Vertex {pass.samples[k], color};
+		}
+		sf::Vector2f offset = arc.position - pass.origin;
+		sf::RenderStates states;
+		states.transform.translate(offset.x, offset.y);
+		draw(render_target, strip, states);
+
+		ring.setOutlineColor(arc.color);
+		for (unsigned int m = 0; m < pass.mark_count; ++m)
+		{
+			const Mark& mark = pass.marks[m];
+			// the pool may have reused it since the update
+			if (!mark.near || mark.point->id() != mark.id)
+				continue;
+			ring.setPosition(mark.point->pos());
+			draw(render_target, ring);
+		}
+	}
+}
+
+void TrajectoryPreview::report(std::ostream& out) const
+{
+	if (updates == 0)
+		return;
+
+	out << "Preview: " << updates << " updates, " << passes << " arcs flown, " << steps << " steps, mean " << update_total / updates << " us, max " << update_max << " us" << std::endl;
+}
@@ -0,0 +1,120 @@
+#ifndef PREVIEW_HPP
+#define PREVIEW_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+
+#include "physics.hpp"
+#include "point.hpp"
+#include "swinger.hpp"
+
+// Where each grappling player would fly if they let go now, and the points
+// they'd pass within grabbing range of. Every player's flight is a body in
+// one SwingerPhysics, so the prediction is the real falling physics and a
+// step advances them all together.
+//
+// An arc's shape only depends on the velocity the player would let go with,
+// so a finished arc is carried forward from frame to frame, moved along with
+// the player, until that velocity or the player's position drifts too far
+// from the ones it was flown from. Then a new arc is flown, a fixed number of
+// steps per frame, and replaces the old one once it's complete.
+//
+// Moving points are checked where they'll be when the player gets to each
+// sample. A carried arc is let go along later than it was flown, so its rings
+// on moving points are checked again every frame and dropped once the point
+// has moved on, and an arc that passed near any moving point is flown again
+// after refly_ticks to pick up the ones that have come into reach.
+class TrajectoryPreview
+{
+	static const unsigned int max_players = 8;
+	static const unsigned int max_steps = 90;
+	static const unsigned int max_marks = 8;
+
+	struct Mark
+	{
+		const Point* point;
+		// the pool reuses points, this is what was marked
+		uint32_t id;
+		// the sample it's in reach of
+		unsigned int sample;
+		// still in reach if the player lets go now
+		bool near;
+	};
+
+	// a flight from origin with velocity, let go at the start of game tick `tick`
+	struct Pass
+	{
+		sf::Vector2f origin;
+		sf::Vector2f velocity;
+		unsigned int tick = 0;
+		// a moving point could have come within reach
+		bool moving = false;
+		sf::Vector2f samples[max_steps];
+		unsigned int length = 0;
+		Mark marks[max_marks];
+		unsigned int mark_count = 0;
+	};
+
+	struct Arc
+	{
+		// grappling, so it wants an arc
+		bool active = false;
+		// the last finished pass, drawn moved to where the player is now
+		bool shown = false;
+		Pass done;
+		sf::Vector2f position;
+		// being flown
+		bool flying = false;
+		Pass next;
+		const Grappable* target = nullptr;
+		float reach = 0.f;
+		float reach2 = 0.f;
+		sf::Color color;
+	};
+
+	SwingerPhysics flight;
+	Arc arcs[max_players];
+	unsigned int player_count = 0;
+
+	sf::VertexArray strip {sf::LinesStrip, max_steps};
+	sf::CircleShape ring;
+
+	uint64_t updates = 0;
+	uint64_t passes = 0;
+	uint64_t steps = 0;
+	sf::Clock clock;
+	sf::Int64 update_total = 0;
+	sf::Int64 update_max = 0;
+
+	void start_pass(unsigned int i, const Swinger& player, const sf::Vector2f& velocity);
+	void finish_pass(unsigned int i);
+public:
+	bool enabled = false;
+	// flight steps per frame, shared by every arc being flown
+	unsigned int budget = 30;
+	// how far the release velocity (px/ms) and position can drift before an arc is flown again
+	float velocity_drift = 0.02f;
+	float position_drift = 32.f;
+	// ticks before an arc that passed near moving points is flown again
+	unsigned int refly_ticks = 30;
+
+	TrajectoryPreview();
+
+	// forget the last run's arcs
+	void reset();
+
+	// follow the players and fly any arcs that drifted, once a frame after
+	// move_points(); points are marked within reach of the player
+	void update(const std::vector<Swinger*>& players, const std::vector<Point*>& points, float bottom);
+
+	void rebase(float dy);
+
+	void draw_on(sf::RenderTarget& render_target);
+
+	void report(std::ostream& out) const;
+};
+
+#endif
@@ -0,0 +1,194 @@
+#include <algorithm>
+#include <cmath>
+
+#include "rope.hpp"
+
+const unsigned int RopePhysics::segments;
+const unsigned int RopePhysics::nodes;
+
+RopePhysics::RopePhysics(unsigned int cap)
+	: capacity {cap}, x(nodes * cap), y(nodes * cap), ox(nodes * cap), oy(nodes * cap), inv_mass(nodes * cap),
+	segment_length(cap), loose_left(cap), state(cap, ROPE_NONE)
+{
+}
+
+unsigned int RopePhysics::add()
+{
+	return count++;
+}
+
+void RopePhysics::attach(unsigned int r, const sf::Vector2f& from, const sf::Vector2f& to)
+{
+	for (unsigned int i = 0; i < nodes; ++i)
+	{
+		unsigned int k = i * capacity + r;
+		float t = (float)i / segments;
+		x[k] = ox[k] = from.x + (to.x - from.x) * t;
+		y[k] = oy[k] = from.y + (to.y - from.y) * t;
+		inv_mass[k] = (i == 0 || i == segments) ? 0.f : 1.f;
+	}
+	float dx = to.x - from.x;
+	float dy = to.y - from.y;
+	segment_length[r] = std::sqrt(dx * dx + dy * dy) / segments;
+	state[r] = ROPE_HELD;
+}
+
+void RopePhysics::hold(unsigned int r, const sf::Vector2f& from, const sf::Vector2f& to)
+{
+	unsigned int a = r;
+	unsigned int b = segments * capacity + r;
+	ox[a] = x[a];
+	oy[a] = y[a];
+	x[a] = from.x;
+	y[a] = from.y;
+	ox[b] = x[b];
+	oy[b] = y[b];
+	x[b] = to.x;
+	y[b] = to.y;
+}
+
+void RopePhysics::release(unsigned int r)
+{
+	if (state[r] != ROPE_HELD)
+		return;
+	inv_mass[r] = 1.f;
+	loose_left[r] = loose_time;
+	state[r] = ROPE_LOOSE;
+}
+
+void RopePhysics::rebase(float dy)
+{
+	for (std::size_t k = 0; k < y.size(); ++k)
+	{
+		y[k] += dy;
+		oy[k] += dy;
+	}
+}
+
+// Like SwingerPhysics, the passes are free functions so __restrict holds.
+// Pinned nodes have no inverse mass, which zeroes their share of every move
+// without a branch.
+
+static void integrate(unsigned int n, float* __restrict x, float* __restrict y, float* __restrict ox, float* __restrict oy,
+	const float* __restrict inv, float gx, float gy, float damping)
+{
+	for (unsigned int i = 0; i < n; ++i)
+	{
+		float nx = x[i] + ((x[i] - ox[i]) * damping + gx) * inv[i];
+		float ny = y[i] + ((y[i] - oy[i]) * damping + gy) * inv[i];
+		// pinned nodes keep the move hold() gave them, so a released end flies off with it
+		ox[i] = x[i] * inv[i] + ox[i] * (1.f - inv[i]);
+		oy[i] = y[i] * inv[i] + oy[i] * (1.f - inv[i]);
+		x[i] = nx;
+		y[i] = ny;
+	}
+}
+
+// one segment of every rope, between nodes a and b
+static void constrain(unsigned int n, float* __restrict ax, float* __restrict ay, float* __restrict bx, float* __restrict by,
+	const float* __restrict ai, const float* __restrict bi, const float* __restrict length)
+{
+	for (unsigned int r = 0; r < n; ++r)
+	{
+		float dx = bx[r] - ax[r];
+		float dy = by[r] - ay[r];
+		float d = std::sqrt(dx * dx + dy * dy);
+		// ropes pull but don't push
+		float stretch = std::max(d - length[r], 0.f);
+		// a segment pinned at both ends comes out at zero anyway
+		float k = stretch / ((d + 1e-6f) * (ai[r] + bi[r] + 1e-6f));
+		ax[r] += dx * k * ai[r];
+		ay[r] += dy * k * ai[r];
+		bx[r] -= dx * k * bi[r];
+		by[r] -= dy * k * bi[r];
+	}
+}
+
+// keep a node of every rope within reach_a segments of one end and reach_b
+// of the other, where they're pinned, which stops a rope stretching under
+// its own weight with only a few passes
+static void tether(unsigned int n, float* __restrict x, float* __restrict y, const float* __restrict inv,
+	const float* __restrict ax, const float* __restrict ay, const float* __restrict a_inv,
+	const float* __restrict bx, const float* __restrict by, const float* __restrict b_inv,
+	const float* __restrict length, float reach_a, float reach_b)
+{
+	for (unsigned int r = 0; r < n; ++r)
+	{
+		float dx = x[r] - ax[r];
+		float dy = y[r] - ay[r];
+		float d = std::sqrt(dx * dx + dy * dy);
+		float over = std::max(d - length[r] * reach_a, 0.f);
+		float k = over / (d + 1e-6f) * inv[r] * (1.f - a_inv[r]);
+		float nx = x[r] - dx * k;
+		float ny = y[r] - dy * k;
+
+		dx = nx - bx[r];
+		dy = ny - by[r];
+		d = std::sqrt(dx * dx + dy * dy);
+		over = std::max(d - length[r] * reach_b, 0.f);
+		k = over / (d + 1e-6f) * inv[r] * (1.f - b_inv[r]);
+		x[r] = nx - dx * k;
+		y[r] = ny - dy * k;
+	}
+}
+
+void RopePhysics::step(const sf::Vector2f& gravity, float dt)
+{
+	bool any = false;
+	for (unsigned int r = 0; r < count; ++r)
+	{
+		if (state[r] == ROPE_HELD)
+		{
+			// take in slack, slower than a pull so the rope sags while it lasts
+			unsigned int b = segments * capacity + r;
+			float dx = x[b] - x[r];
+			float dy = y[b] - y[r];
+			float d = std::sqrt(dx * dx + dy * dy);
+			float length = segment_length[r] * segments;
+			if (d > length)
+				length = d;
+			else
+				length += (d - length) * std::min(reel_rate * dt, 1.f);
+			segment_length[r] = length / segments;
+		}
+		else if (state[r] == ROPE_LOOSE)
+		{
+			loose_left[r] -= dt;
+			if (loose_left[r] <= 0.f)
+			{
+				state[r] = ROPE_NONE;
+				for (unsigned int i = 0; i < nodes; ++i)
+					inv_mass[i * capacity + r] = 0.f;
+			}
+		}
+		any |= state[r] != ROPE_NONE;
+	}
+	if (!any)
+		return;
+
+	integrate(nodes * capacity, x.data(), y.data(), ox.data(), oy.data(), inv_mass.data(),
+		gravity.x * dt * dt, gravity.y * dt * dt, damping);
+
+	// even segments then odd ones, each half doesn't share nodes so the passes
+	// don't wait on each other the way a plain sweep down the rope does, then
+	// the tethers to both ends
+	unsigned int end = segments * capacity;
+	for (unsigned int it = 0; it < iterations; ++it)
+	{
+		for (unsigned int first = 0; first < 2; ++first)
+		{
+			for (unsigned int i = first; i < segments; i += 2)
+			{
+				unsigned int a = i * capacity;
+				unsigned int b = a + capacity;
+				constrain(count, &x[a], &y[a], &x[b], &y[b], &inv_mass[a], &inv_mass[b], segment_length.data());
+			}
+		}
+		for (unsigned int i = 1; i < segments; ++i)
+		{
+			unsigned int k = i * capacity;
+			tether(count, &x[k], &y[k], &inv_mass[k], &x[0], &y[0], &inv_mass[0], &x[end], &y[end], &inv_mass[end],
+				segment_length.data(), i, segments - i);
+		}
+	}
+}
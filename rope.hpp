@@ -0,0 +1,86 @@
+#ifndef ROPE_HPP
+#define ROPE_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include <SFML/System.hpp>
+
+// rope states
+enum : uint8_t
+{
+	ROPE_NONE = 0,
+	// pinned at both ends, to a swinger and what it's grappling
+	ROPE_HELD = 1,
+	// let go of, hanging off the target for a moment
+	ROPE_LOOSE = 2,
+};
+
+// Ropes between swingers and their grapple targets, each a chain of nodes
+// moved by Verlet integration and pulled back to length by a few passes over
+// its segments and tethers to its pinned ends. Nodes are stored node by node
+// across every rope, so a pass over one segment runs over all the ropes at
+// once and vectorizes. Rope memory is fixed when it's created. This is only
+// for show, SwingerPhysics still treats the rope as a rod of grap_dist.
+class RopePhysics
+{
+public:
+	static const unsigned int segments = 32;
+	static const unsigned int nodes = segments + 1;
+
+	// node i of rope r is at i * capacity + r
+	const unsigned int capacity;
+	std::vector<float> x;
+	std::vector<float> y;
+	// where each node was last tick
+	std::vector<float> ox;
+	std::vector<float> oy;
+	// 1 for free nodes, 0 for ends pinned to something
+	std::vector<float> inv_mass;
+
+	// per rope
+	std::vector<float> segment_length;
+	// ms left before a loose rope goes away
+	std::vector<float> loose_left;
+	std::vector<uint8_t> state;
+
+	unsigned int iterations = 4;
+	// velocity kept per tick
+	float damping = 0.99f;
+	// fraction of the slack reeled in per ms
+	float reel_rate = 0.004f;
+	float loose_time = 600.f;
+
+	explicit RopePhysics(unsigned int cap);
+
+	// returns the new rope's index, no more than capacity
+	unsigned int add();
+
+	inline unsigned int size() const
+	{
+		return count;
+	}
+
+	inline sf::Vector2f node(unsigned int r, unsigned int i) const
+	{
+		return sf::Vector2f {x[i * capacity + r], y[i * capacity + r]};
+	}
+
+	// a straight rope from a swinger to its new target
+	void attach(unsigned int r, const sf::Vector2f& from, const sf::Vector2f& to);
+
+	// move the pinned ends to where they are this tick, before step()
+	void hold(unsigned int r, const sf::Vector2f& from, const sf::Vector2f& to);
+
+	// let go of the swinger's end, which keeps the swinger's last movement
+	void release(unsigned int r);
+
+	void rebase(float dy);
+
+	// advance every rope dt ms
+	void step(const sf::Vector2f& gravity, float dt);
+private:
+	unsigned int count = 0;
+};
+
+#endif
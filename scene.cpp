@@ -0,0 +1,114 @@
+#include <cmath>
+
+#include "draw.hpp"
+#include "scene.hpp"
+
+Scene::Scene()
+{
+	layers.reserve(max_layers);
+	cached_positions.reserve(max_layers);
+}
+
+bool Scene::create(unsigned int w, unsigned int h, float tile_size)
+{
+	tile = tile_size;
+	have_cache = cache.create(w, h);
+	if (have_cache)
+		cache_sprite.setTexture(cache.getTexture(), true);
+	dirty = true;
+	return have_cache;
+}
+
+void Scene::static_layers(std::initializer_list<const sf::Sprite*> sprites)
+{
+	layers.assign(sprites);
+	cached_positions.resize(layers.size());
+	dirty = true;
+}
+
+bool Scene::valid(const sf::View& camera) const
+{
+	if (dirty)
+		return false;
+
+	auto& center = camera.getCenter();
+	auto& size = camera.getSize();
+	if (size.x != cached.width || center.x - size.x / 2.f != cached.left)
+		return false;
+	float top = center.y - size.y / 2.f;
+	if (top < cached.top || top + size.y > cached.top + cached.height)
+		return false;
+
+	for (std::size_t i = 0; i < layers.size(); ++i)
+	{
+		if (layers[i]->getPosition() != cached_positions[i])
+			return false;
+	}
+	return true;
+}
+
+bool Scene::render(const sf::View& camera)
+{
+	auto& center = camera.getCenter();
+	auto& size = camera.getSize();
+	auto pixels = cache.getSize();
+	// the cache is as wide as the target, so a cache pixel is a screen pixel
+	float scale = size.x / pixels.x;
+	float top = center.y - size.y / 2.f;
+	// the view climbs, so the margin goes above it: a tile over the view's tile
+	float cache_top = std::floor(top / tile) * tile - tile;
+	// zoomed out too far for the cache to hold the view
+	if (top - cache_top + size.y > pixels.y * scale)
+	{
+		dirty = true;
+		return false;
+	}
+
+	cached.left = center.x - size.x / 2.f;
+	cached.width = size.x;
+	cached.top = cache_top;
+	cached.height = pixels.y * scale;
+
+	cache.setView(sf::View {cached});
+	cache.clear();
+	for (std::size_t i = 0; i < layers.size(); ++i)
+	{
+		draw(cache, *layers[i]);
+		cached_positions[i] = layers[i]->getPosition();
+	}
+	cache.display();
+
+	cache_sprite.setPosition(cached.left, cached.top);
+	cache_sprite.setScale(scale, scale);
+	dirty = false;
+	++renders;
+	return true;
+}
+
+void Scene::draw_static(sf::RenderTarget& target, const sf::View& camera)
+{
+	++frames;
+	if (have_cache)
+	{
+		bool hit = valid(camera);
+		if (hit)
+			++hits;
+		if (hit || render(camera))
+		{
+			// the layers start from black, same as the target
+			draw(target, cache_sprite, sf::BlendNone);
+			return;
+		}
+	}
+
+	for (auto& layer : layers)
+		draw(target, *layer);
+}
+
+void Scene::report(std::ostream& out) const
+{
+	if (frames == 0)
+		return;
+
+	out << "Scene: " << hits << " of " << frames << " frames drawn from the static cache, " << renders << " cache renders" << std::endl;
+}
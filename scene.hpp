@@ -0,0 +1,54 @@
+#ifndef SCENE_HPP
+#define SCENE_HPP
+
+#include <initializer_list>
+#include <ostream>
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+
+// The static layers under the world, background, floor and signs, which only
+// move when the background wraps or the world is rebased. They're composited
+// into a cache covering the view plus background tiles above it and drawn
+// from there as one sprite; the cache is rebuilt when the view climbs out of
+// it (past the tile above its own), the zoom changes or one of the layers
+// moves.
+class Scene
+{
+	static const unsigned int max_layers = 8;
+
+	std::vector<const sf::Sprite*> layers;
+	// where the layers were when the cache was drawn
+	std::vector<sf::Vector2f> cached_positions;
+
+	sf::RenderTexture cache;
+	bool have_cache = false;
+	bool dirty = true;
+	float tile = 1.f;
+	// the world rectangle the cache holds
+	sf::FloatRect cached;
+	sf::Sprite cache_sprite;
+
+	unsigned int frames = 0;
+	unsigned int hits = 0;
+	unsigned int renders = 0;
+
+	bool valid(const sf::View& camera) const;
+	// false if the view doesn't fit
+	bool render(const sf::View& camera);
+public:
+	Scene();
+
+	// a cache of w by h pixels, views are cached from the tile boundary above their own
+	bool create(unsigned int w, unsigned int h, float tile_size);
+
+	// the layers to draw, bottom first
+	void static_layers(std::initializer_list<const sf::Sprite*> sprites);
+
+	// draw the static layers as seen by camera, which must be the target's view
+	void draw_static(sf::RenderTarget& target, const sf::View& camera);
+
+	void report(std::ostream& out) const;
+};
+
+#endif
@@ -0,0 +1,437 @@
+// climb-shaderbench: GPU time of the screen shaders, with no window or display.
+//
+// SFML only makes GL contexts through a window system, so this opens one with
+// EGL instead (Mesa's surfaceless platform when it's there, which is what a
+// display-less CI box running llvmpipe has) and draws the same passes the
+// game does into a framebuffer object.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+
+#define GL_GLEXT_PROTOTYPES
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#include <SFML/System.hpp>
+
+#include "shaders.hpp"
+#include "sim_math.hpp"
+
+// an offscreen GL context with nothing to show it on
+class HeadlessGL
+{
+	EGLDisplay display = EGL_NO_DISPLAY;
+	EGLContext context = EGL_NO_CONTEXT;
+public:
+	HeadlessGL() = default;
+	HeadlessGL(const HeadlessGL&) = delete;
+	HeadlessGL& operator=(const HeadlessGL&) = delete;
+
+	~HeadlessGL()
+	{
+		if (context != EGL_NO_CONTEXT)
+		{
+			eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+			eglDestroyContext(display, context);
+		}
+		if (display != EGL_NO_DISPLAY)
+			eglTerminate(display);
+	}
+
+	bool open()
+	{
+		auto get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+		if (get_platform_display)
+			display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+		if (display == EGL_NO_DISPLAY)
+			display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+		if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr))
+			return false;
+
+		// the game's shaders are GLSL 1.30 with the fixed function vertex stage, so a compatibility context
+		if (!eglBindAPI(EGL_OPENGL_API))
+			return false;
+		const EGLint attribs[] = {EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+		EGLConfig config = nullptr;
+		EGLint configs = 0;
+		if (!eglChooseConfig(display, attribs, &config, 1, &configs) || configs == 0)
+			config = nullptr;
+
+		context = eglCreateContext(display, config, EGL_NO_CONTEXT, nullptr);
+		return context != EGL_NO_CONTEXT && eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context);
+	}
+};
+
+struct ShaderResult
+{
+	std::string name;
+	// each frame is drawn and waited for with glFinish
+	float median_ms;
+	float max_ms;
+	// from timer queries, -1 without them
+	float gpu_median_ms;
+};
+
+static float median(std::vector<float>& ms)
+{
+	std::sort(ms.begin(), ms.end());
+	return ms[ms.size() / 2];
+}
+
+class ShaderBench
+{
+	unsigned int width;
+	unsigned int height;
+	GLuint target = 0;
+	GLuint framebuffer = 0;
+	std::vector<GLuint> frames;
+	bool timer_queries = false;
+
+	// the bottom `rows` of the frame, where the game draws the lava band
+	void draw_quad(unsigned int rows)
+	{
+		float v = (float)rows / height;
+		float y = 2.f * v - 1.f;
+		glBegin(GL_QUADS);
+		glTexCoord2f(0.f, 0.f);
+		glVertex2f(-1.f, -1.f);
+		glTexCoord2f(1.f, 0.f);
+		glVertex2f(1.f, -1.f);
+		glTexCoord2f(1.f, v);
+		glVertex2f(1.f, y);
+		glTexCoord2f(0.f, v);
+		glVertex2f(-1.f, y);
+		glEnd();
+	}
+
+	GLuint make_texture(const uint8_t* pixels)
+	{
+		GLuint texture;
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+		return texture;
+	}
+public:
+	ShaderBench(unsigned int w, unsigned int h)
+		: width {w}, height {h}
+	{}
+
+	~ShaderBench()
+	{
+		if (!frames.empty())
+			glDeleteTextures(frames.size(), frames.data());
+		if (framebuffer)
+			glDeleteFramebuffers(1, &framebuffer);
+		if (target)
+			glDeleteTextures(1, &target);
+	}
+
+	bool init()
+	{
+		int major = 0;
+		const char* version = (const char*)glGetString(GL_VERSION);
+		if (!version || std::sscanf(version, "%d", &major) != 1 || major < 3)
+			return false;
+		const char* renderer = (const char*)glGetString(GL_RENDERER);
+		std::cout << "GL " << version << ", " << (renderer ? renderer : "unknown renderer") << "\n";
+		// software rasterizers draw at glFinish, after the query has ended, so theirs only time the submission
+		std::string name = renderer ? renderer : "";
+		bool software = name.find("llvmpipe") != std::string::npos || name.find("softpipe") != std::string::npos || name.find("swrast") != std::string::npos;
+		timer_queries = !software && (major > 3 || std::string {version}.compare(0, 3, "3.3") >= 0);
+
+		target = make_texture(nullptr);
+		glGenFramebuffers(1, &framebuffer);
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target, 0);
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+			return false;
+		glViewport(0, 0, width, height);
+		glDisable(GL_BLEND);
+		glEnable(GL_TEXTURE_2D);
+		return true;
+	}
+
+	// stand ins for the game's frames: dark sky, a floor, points and players at different heights
+	void synthetic_frames(unsigned int count)
+	{
+		SimRandom random;
+		std::vector<uint8_t> pixels(width * height * 4);
+		for (unsigned int f = 0; f < count; ++f)
+		{
+			for (unsigned int y = 0; y < height; ++y)
+			{
+				for (unsigned int x = 0; x < width; ++x)
+				{
+					uint8_t* p = &pixels[(y * width + x) * 4];
+					p[0] = 40 + y * 40 / height;
+					p[1] = 40 + y * 30 / height;
+					p[2] = 70 + (x / 64 + y / 64 + f) % 2 * 10;
+					p[3] = 255;
+				}
+			}
+			for (unsigned int i = 0; i < 24; ++i)
+			{
+				unsigned int cx = random.next() % width, cy = random.next() % height;
+				uint8_t r = random.next(), g = random.next(), b = random.next();
+				for (unsigned int y = cy; y < std::min(height, cy + 32); ++y)
+				{
+					for (unsigned int x = cx; x < std::min(width, cx + 32); ++x)
+					{
+						uint8_t* p = &pixels[(y * width + x) * 4];
+						p[0] = r;
+						p[1] = g;
+						p[2] = b;
+					}
+				}
+			}
+			frames.push_back(make_texture(pixels.data()));
+		}
+	}
+
+	// frames recorded with climb --capture-raw, which are top row first
+	bool recorded_frames(const std::string& path, unsigned int max_frames)
+	{
+		std::ifstream in {path, std::ios::binary};
+		const std::size_t row = width * 4;
+		std::vector<uint8_t> file(row * height);
+		std::vector<uint8_t> pixels(row * height);
+		while (frames.size() < max_frames && in.read((char*)file.data(), file.size()))
+		{
+			// GL wants the bottom row first
+			for (unsigned int y = 0; y < height; ++y)
+				std::copy(&file[(height - 1 - y) * row], &file[(height - y) * row], &pixels[y * row]);
+			frames.push_back(make_texture(pixels.data()));
+		}
+		return !frames.empty();
+	}
+
+	// compile and link, 0 on failure with the log on stderr
+	GLuint load(const std::string& file, const ShaderQuality& quality)
+	{
+		std::string src;
+		if (!read_shader_variant(file, quality, src))
+		{
+			std::cerr << "Failed to read " << file << std::endl;
+			return 0;
+		}
+
+		const char* text = src.c_str();
+		GLuint shader = glCreateShader(GL_FRAGMENT_SHADER);
+		glShaderSource(shader, 1, &text, nullptr);
+		glCompileShader(shader);
+		GLuint program = glCreateProgram();
+		glAttachShader(program, shader);
+		glLinkProgram(program);
+		glDeleteShader(shader);
+
+		GLint linked = 0;
+		glGetProgramiv(program, GL_LINK_STATUS, &linked);
+		if (!linked)
+		{
+			char log[4096];
+			glGetProgramInfoLog(program, sizeof(log), nullptr, log);
+			std::cerr << "Failed to build " << file << ": " << log << std::endl;
+			glDeleteProgram(program);
+			return 0;
+		}
+		return program;
+	}
+
+	// draw `count` frames of the bottom `rows` after `warmup`, half in the intro and half after it, with time running at 60 FPS
+	ShaderResult run(const std::string& name, GLuint program, unsigned int rows, unsigned int warmup, unsigned int count)
+	{
+		glUseProgram(program);
+		glUniform1i(glGetUniformLocation(program, "texture"), 0);
+		glUniform1f(glGetUniformLocation(program, "winw"), (float)width);
+		glUniform1f(glGetUniformLocation(program, "winh"), (float)height);
+		GLint time = glGetUniformLocation(program, "time");
+		GLint start_time = glGetUniformLocation(program, "start_time");
+
+		std::vector<GLuint> queries;
+		if (timer_queries)
+		{
+			queries.resize(count);
+			glGenQueries(count, queries.data());
+		}
+
+		std::vector<float> frame_ms;
+		sf::Clock clock;
+		glFinish();
+		for (unsigned int f = 0; f < warmup + count; ++f)
+		{
+			float t = f / 60.f;
+			// the intro ends halfway, so the darkening fades in while the frames are timed
+			float intro_end = (warmup + count / 2) / 60.f;
+			glUniform1f(time, t);
+			glUniform1f(start_time, t < intro_end ? -1.f : intro_end);
+			glBindTexture(GL_TEXTURE_2D, frames[f % frames.size()]);
+
+			bool timed = f >= warmup;
+			clock.restart();
+			if (timed && timer_queries)
+				glBeginQuery(GL_TIME_ELAPSED, queries[f - warmup]);
+			draw_quad(rows);
+			if (timed && timer_queries)
+				glEndQuery(GL_TIME_ELAPSED);
+			glFinish();
+			if (timed)
+				frame_ms.push_back(clock.getElapsedTime().asMicroseconds() / 1000.f);
+		}
+		// median() sorts, so the slowest frame ends up last
+		float frame_median = median(frame_ms);
+		ShaderResult result {name, frame_median, frame_ms.back(), -1.f};
+
+		if (timer_queries)
+		{
+			std::vector<float> gpu_ms;
+			for (auto query : queries)
+			{
+				GLuint64 ns = 0;
+				glGetQueryObjectui64v(query, GL_QUERY_RESULT, &ns);
+				gpu_ms.push_back(ns / 1e6f);
+			}
+			glDeleteQueries(count, queries.data());
+			result.gpu_median_ms = median(gpu_ms);
+		}
+		glUseProgram(0);
+		return result;
+	}
+};
+
+static bool write_json(const std::string& path, unsigned int w, unsigned int h, unsigned int band, const std::vector<ShaderResult>& results)
+{
+	std::ofstream out {path};
+	out << "{\"unit\": \"ms/frame\", \"width\": " << w << ", \"height\": " << h << ", \"band\": " << band << ", \"results\": [\n";
+	for (std::size_t i = 0; i < results.size(); ++i)
+	{
+		const ShaderResult& r = results[i];
+		char line[256];
+		std::snprintf(line, sizeof(line), "{\"name\": \"%s\", \"median\": %.4f, \"max\": %.4f, \"gpu_median\": %.4f}", r.name.c_str(), r.median_ms, r.max_ms, r.gpu_median_ms);
+		out << line << (i + 1 < results.size() ? ",\n" : "\n");
+	}
+	out << "]}\n";
+	return out.good();
+}
+
+int main(int argc, char* argv[])
+{
+	unsigned int width = 1600;
+	unsigned int height = 900;
+	// main.cpp's lava_band, the rows the lava shader covers once the intro is over
+	unsigned int band = 224;
+	unsigned int warmup = 10;
+	unsigned int count = 120;
+	std::string tier = "all";
+	std::string recorded;
+	std::string json_path;
+	std::vector<std::string> files;
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		if (arg == "--size" && i + 1 < argc && std::sscanf(argv[i + 1], "%ux%u", &width, &height) == 2 && width && height)
+			++i;
+		else if (arg == "--band" && i + 1 < argc && std::atoi(argv[i + 1]) > 0)
+			band = std::atoi(argv[++i]);
+		else if (arg == "--frames" && i + 1 < argc && std::atoi(argv[i + 1]) > 0)
+			count = std::atoi(argv[++i]);
+		else if (arg == "--warmup" && i + 1 < argc && std::atoi(argv[i + 1]) >= 0)
+			warmup = std::atoi(argv[++i]);
+		else if (arg == "--tier" && i + 1 < argc && (std::string {argv[i + 1]} == "all" || find_shader_tier(argv[i + 1]) >= 0))
+			tier = argv[++i];
+		else if (arg == "--input" && i + 1 < argc)
+			recorded = argv[++i];
+		else if (arg == "--json" && i + 1 < argc)
+			json_path = argv[++i];
+		else if (arg.compare(0, 2, "--") != 0)
+			files.push_back(arg);
+		else
+		{
+			std::cerr << "Usage: " << argv[0] << " [--size WxH] [--band ROWS] [--frames N] [--warmup N] [--tier low|medium|high|all] [--input CAPTURE.rgba] [--json FILE] [SHADER.glsl...]\n";
+			return 1;
+		}
+	}
+	if (files.empty())
+		files = {"fragment.glsl", "darken.glsl"};
+	band = std::min(band, height);
+
+	HeadlessGL gl;
+	if (!gl.open())
+	{
+		std::cerr << "Failed to create a headless GL context" << std::endl;
+		return 1;
+	}
+
+	ShaderBench bench {width, height};
+	if (!bench.init())
+	{
+		std::cerr << "Need OpenGL 3.0 with framebuffer objects" << std::endl;
+		return 1;
+	}
+	if (!recorded.empty())
+	{
+		// a few seconds of frames is plenty and keeps the textures under 100 MB at 1600x900
+		if (!bench.recorded_frames(recorded, 16))
+		{
+			std::cerr << "No " << width << "x" << height << " frames in " << recorded << std::endl;
+			return 1;
+		}
+	}
+	else
+		bench.synthetic_frames(8);
+
+	std::vector<ShaderResult> results;
+	for (auto& file : files)
+	{
+		// only the darkening covers the whole window
+		std::size_t slash = file.find_last_of("/\\");
+		bool full_screen = file.substr(slash == std::string::npos ? 0 : slash + 1) == "darken.glsl";
+		for (unsigned int t = 0; t < shader_tier_count; ++t)
+		{
+			if (tier != "all" && tier != shader_tiers[t].name)
+				continue;
+			GLuint program = bench.load(file, shader_tiers[t]);
+			if (!program)
+				return 1;
+			results.push_back(bench.run(file + "/" + shader_tiers[t].name, program, full_screen ? height : band, warmup, count));
+			glDeleteProgram(program);
+
+			const ShaderResult& r = results.back();
+			std::printf("%-24s %8.3f ms/frame  max %8.3f", r.name.c_str(), r.median_ms, r.max_ms);
+			if (r.gpu_median_ms >= 0.f)
+				std::printf("  gpu %8.3f", r.gpu_median_ms);
+			std::printf("\n");
+			std::fflush(stdout);
+		}
+	}
+
+	if (!json_path.empty() && !write_json(json_path, width, height, band, results))
+	{
+		std::cerr << "Failed to write " << json_path << std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+#else
+
+int main()
+{
+	std::cerr << "climb-shaderbench needs EGL, it only builds on Linux" << std::endl;
+	return 1;
+}
+
+#endif
@@ -0,0 +1,116 @@
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "shaders.hpp"
+
+const ShaderQuality shader_tiers[] = {
+	{"low", 1, 5.f, false, false},
+	{"medium", 5, 10.f, true, true},
+	{"high", 10, 5.f, true, true},
+};
+const unsigned int shader_tier_count = sizeof(shader_tiers) / sizeof(shader_tiers[0]);
+
+int find_shader_tier(const std::string& name)
+{
+	for (unsigned int i = 0; i < shader_tier_count; ++i)
+	{
+		if (name == shader_tiers[i].name)
+			return i;
+	}
+	return -1;
+}
+
+bool read_shader_variant(const std::string& file, const ShaderQuality& quality, std::string& src)
+{
+	std::ifstream in {file};
+	if (!in)
+		return false;
+	std::stringstream source;
+	source << in.rdbuf();
+	src = source.str();
+
+	std::stringstream defines;
+	defines << "#define SAMPLES " << quality.samples << "\n";
+	defines << "#define GLOWSIZE " << quality.glowsize << (quality.glowsize == (int)quality.glowsize ? ".0" : "") << "\n";
+	defines << "#define NOISE " << (quality.noise ? 1 : 0) << "\n";
+	defines << "#define BLOOM " << (quality.bloom ? 1 : 0) << "\n";
+
+	// defines have to come after #version
+	std::size_t pos = 0;
+	if (src.compare(0, 8, "#version") == 0 || (pos = src.find("\n#version")) != std::string::npos)
+	{
+		pos = src.find('\n', pos + 1);
+		pos = pos == std::string::npos ? src.size() : pos + 1;
+	}
+	else
+		pos = 0;
+	src.insert(pos, defines.str());
+	return true;
+}
+
+bool load_shader_variant(sf::Shader& shader, const std::string& file, const ShaderQuality& quality)
+{
+	std::string src;
+	return read_shader_variant(file, quality, src) && shader.loadFromMemory(src, sf::Shader::Fragment);
+}
+
+int benchmark_shader_tiers(const std::string& file, unsigned int w, unsigned int h, float budget_ms)
+{
+	const unsigned int warmup = 3;
+	const unsigned int frames = 30;
+
+	sf::RenderTexture source;
+	sf::RenderTexture dest;
+	if (!source.create(w, h) || !dest.create(w, h))
+		return -1;
+	source.clear(sf::Color {60, 60, 80});
+	source.display();
+	sf::Sprite screen {source.getTexture()};
+
+	// copyToImage waits for the GPU, time it alone so it can be taken out
+	sf::Clock clock;
+	dest.clear();
+	dest.display();
+	dest.getTexture().copyToImage();
+	clock.restart();
+	dest.getTexture().copyToImage();
+	float readback_ms = clock.getElapsedTime().asMicroseconds() / 1000.f;
+
+	int best = -1;
+	for (unsigned int i = 0; i < shader_tier_count; ++i)
+	{
+		sf::Shader shader;
+		if (!load_shader_variant(shader, file, shader_tiers[i]))
+			return best;
+		shader.setParameter("texture", sf::Shader::CurrentTexture);
+		shader.setParameter("winw", (float)w);
+		shader.setParameter("winh", (float)h);
+		// intro mode, the whole screen is lava
+		shader.setParameter("start_time", -1.f);
+
+		for (unsigned int f = 0; f < warmup + frames; ++f)
+		{
+			if (f == warmup)
+			{
+				dest.getTexture().copyToImage();
+				clock.restart();
+			}
+			shader.setParameter("time", f / 60.f);
+			dest.draw(screen, &shader);
+			dest.display();
+		}
+		dest.getTexture().copyToImage();
+		float ms = (clock.getElapsedTime().asMicroseconds() / 1000.f - readback_ms) / frames;
+
+		std::cerr << "Shader quality " << shader_tiers[i].name << ": " << ms << " ms per frame\n";
+
+		// tiers get more expensive, the cheapest is always kept as a fallback
+		if (best < 0 || ms <= budget_ms)
+			best = i;
+		else
+			break;
+	}
+
+	return best;
+}
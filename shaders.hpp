@@ -0,0 +1,35 @@
+#ifndef SHADERS_HPP
+#define SHADERS_HPP
+
+#include <string>
+
+#include <SFML/Graphics.hpp>
+
+// compile time settings for the lava shader
+struct ShaderQuality
+{
+	const char* name;
+	int samples;
+	float glowsize;
+	bool noise;
+	bool bloom;
+};
+
+// from cheapest to most expensive
+extern const ShaderQuality shader_tiers[];
+extern const unsigned int shader_tier_count;
+
+// index of the named tier, or -1
+int find_shader_tier(const std::string& name);
+
+// read a fragment shader's source with the quality settings defined after its #version line
+bool read_shader_variant(const std::string& file, const ShaderQuality& quality, std::string& src);
+
+// load a fragment shader with the quality settings defined after its #version line
+bool load_shader_variant(sf::Shader& shader, const std::string& file, const ShaderQuality& quality);
+
+// render a full screen lava pass offscreen for each tier and pick the best one that fits
+// in budget_ms per frame, or -1 if the shaders can't be loaded
+int benchmark_shader_tiers(const std::string& file, unsigned int w, unsigned int h, float budget_ms);
+
+#endif
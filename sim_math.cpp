@@ -0,0 +1,193 @@
+#define _USE_MATH_DEFINES
+#include <cstring>
+
+#include "sim_math.hpp"
+
+// sin(i * pi / 512) in Q30
+static const int32_t sin_table[257] = {
+	0, 6588356, 13176464, 19764076, 26350943, 32936819, 39521455, 46104602, 52686014, 59265442,
+	65842639, 72417357, 78989349, 85558366, 92124163, 98686491, 105245103, 111799753, 118350194,
+	124896179, 131437462, 137973796, 144504935, 151030634, 157550647, 164064728, 170572633, 177074115,
+	183568930, 190056834, 196537583, 203010932, 209476638, 215934457, 222384147, 228825464, 235258165,
+	241682010, 248096755, 254502159, 260897982, 267283981, 273659918, 280025552, 286380643, 292724951,
+	299058239, 305380268, 311690799, 317989595, 324276419, 330551034, 336813204, 343062693, 349299266,
+	355522689, 361732726, 367929144, 374111709, 380280190, 386434353, 392573967, 398698801, 404808624,
+	410903207, 416982319, 423045732, 429093217, 435124548, 441139496, 447137835, 453119340, 459083786,
+	465030947, 470960600, 476872522, 482766489, 488642281, 494499676, 500338453, 506158392, 511959275,
+	517740883, 523502998, 529245404, 534967884, 540670223, 546352205, 552013618, 557654248, 563273883,
+	568872310, 574449320, 580004702, 585538248, 591049748, 596538995, 602005783, 607449906, 612871159,
+	618269338, 623644239, 628995660, 634323400, 639627258, 644907034, 650162530, 655393548, 660599890,
+	665781362, 670937767, 676068911, 681174602, 686254647, 691308855, 696337036, 701339000, 706314559,
+	711263525, 716185713, 721080937, 725949013, 730789757, 735602987, 740388522, 745146182, 749875788,
+	754577161, 759250125, 763894504, 768510122, 773096806, 777654384, 782182683, 786681534, 791150767,
+	795590213, 799999706, 804379079, 808728167, 813046808, 817334838, 821592095, 825818421, 830013654,
+	834177638, 838310216, 842411232, 846480531, 850517961, 854523370, 858496606, 862437520, 866345964,
+	870221790, 874064853, 877875009, 881652112, 885396022, 889106597, 892783698, 896427186, 900036924,
+	903612776, 907154608, 910662286, 914135678, 917574653, 920979082, 924348837, 927683790, 930983817,
+	934248793, 937478595, 940673101, 943832191, 946955747, 950043650, 953095785, 956112036, 959092290,
+	962036435, 964944360, 967815955, 970651112, 973449725, 976211688, 978936898, 981625251, 984276646,
+	986890984, 989468165, 992008094, 994510675, 996975812, 999403415, 1001793390, 1004145648,
+	1006460100, 1008736660, 1010975242, 1013175761, 1015338134, 1017462281, 1019548121, 1021595575,
+	1023604567, 1025575020, 1027506862, 1029400018, 1031254418, 1033069992, 1034846671, 1036584389,
+	1038283080, 1039942680, 1041563127, 1043144360, 1044686319, 1046188946, 1047652185, 1049075980,
+	1050460278, 1051805027, 1053110176, 1054375676, 1055601479, 1056787540, 1057933813, 1059040255,
+	1060106826, 1061133483, 1062120190, 1063066909, 1063973603, 1064840240, 1065666786, 1066453210,
+	1067199483, 1067905576, 1068571464, 1069197120, 1069782521, 1070327646, 1070832474, 1071296985,
+	1071721163, 1072104991, 1072448455, 1072751542, 1073014240, 1073236540, 1073418433, 1073559913,
+	1073660973, 1073721611, 1073741824
+};
+
+// atan(i / 256) in Q30
+static const int32_t atan_table[257] = {
+	0, 4194283, 8388437, 12582336, 16775851, 20968854, 25161218, 29352814, 33543516, 37733196,
+	41921726, 46108981, 50294833, 54479155, 58661822, 62842708, 67021687, 71198634, 75373424,
+	79545932, 83716036, 87883610, 92048532, 96210679, 100369930, 104526161, 108679253, 112829084,
+	116975536, 121118487, 125257820, 129393416, 133525159, 137652930, 141776614, 145896097, 150011262,
+	154121996, 158228185, 162329719, 166426484, 170518371, 174605269, 178687069, 182763663, 186834944,
+	190900805, 194961140, 199015846, 203064818, 207107953, 211145151, 215176309, 219201328, 223220110,
+	227232556, 231238569, 235238055, 239230917, 243217063, 247196400, 251168835, 255134279, 259092643,
+	263043837, 266987774, 270924369, 274853536, 278775192, 282689253, 286595638, 290494267, 294385059,
+	298267937, 302142824, 306009643, 309868320, 313718782, 317560955, 321394768, 325220151, 329037035,
+	332845353, 336645037, 340436023, 344218245, 347991640, 351756148, 355511705, 359258254, 362995735,
+	366724092, 370443267, 374153206, 377853855, 381545162, 385227074, 388899541, 392562515, 396215946,
+	399859787, 403493994, 407118521, 410733324, 414338361, 417933591, 421518973, 425094468, 428660037,
+	432215645, 435761254, 439296830, 442822340, 446337750, 449843028, 453338145, 456823070, 460297774,
+	463762232, 467216414, 470660297, 474093856, 477517067, 480929907, 484332355, 487724391, 491105994,
+	494477146, 497837829, 501188027, 504527723, 507856902, 511175551, 514483656, 517781204, 521068185,
+	524344587, 527610402, 530865619, 534110231, 537344232, 540567613, 543780370, 546982499, 550173994,
+	553354853, 556525073, 559684652, 562833591, 565971887, 569099543, 572216558, 575322936, 578418678,
+	581503788, 584578271, 587642129, 590695370, 593737999, 596770023, 599791448, 602802283, 605802536,
+	608792216, 611771334, 614739898, 617697921, 620645413, 623582386, 626508854, 629424828, 632330323,
+	635225352, 638109930, 640984073, 643847795, 646701114, 649544044, 652376604, 655198810, 658010682,
+	660812236, 663603492, 666384468, 669155185, 671915663, 674665921, 677405981, 680135863, 682855589,
+	685565182, 688264663, 690954054, 693633380, 696302662, 698961924, 701611191, 704250487, 706879836,
+	709499262, 712108791, 714708448, 717298260, 719878250, 722448447, 725008876, 727559563, 730100536,
+	732631822, 735153448, 737665442, 740167831, 742660643, 745143906, 747617650, 750081902, 752536690,
+	754982045, 757417995, 759844569, 762261796, 764669707, 767068330, 769457696, 771837835, 774208776,
+	776570551, 778923188, 781266719, 783601175, 785926586, 788242982, 790550395, 792848855, 795138394,
+	797419043, 799690833, 801953796, 804207961, 806453363, 808690030, 810917996, 813137292, 815347949,
+	817549999, 819743474, 821928406, 824104826, 826272767, 828432260, 830583337, 832726030, 834860371,
+	836986393, 839104126, 841213603, 843314857
+};
+
+// pi and pi / 2 in Q30
+static const int64_t pi_q30 = 3373259426;
+static const int64_t half_pi_q30 = 1686629713;
+
+static const float q30_to_float = 1.f / 1073741824.f;
+
+// isqrt of the top of each 2^43 wide bucket, rounded up, seeds the square root
+static const uint32_t sqrt_seed[64] = {
+	2965821, 4194304, 5136953, 5931642, 6631777, 7264748, 7846825, 8388608, 8897463, 9378749, 9836515,
+	10273905, 10693419, 11097086, 11486575, 11863284, 12228393, 12582912, 12927714, 13263554,
+	13591099, 13910933, 14223577, 14529496, 14829105, 15122779, 15410857, 15693649, 15971434,
+	16244470, 16512992, 16777216, 17037344, 17293559, 17546033, 17794925, 18040384, 18282548,
+	18521545, 18757498, 18990520, 19220716, 19448188, 19673030, 19895331, 20115176, 20332644,
+	20547810, 20760746, 20971520, 21180197, 21386838, 21591502, 21794243, 21995116, 22194171,
+	22391457, 22587019, 22780902, 22973150, 23163801, 23352897, 23540473, 23726567
+};
+
+// floor(sqrt(v)) for v < 2^49 by Newton's method from an overestimate
+static uint64_t isqrt49(uint64_t v)
+{
+	uint64_t x = sqrt_seed[v >> 43];
+	for (;;)
+	{
+		uint64_t y = (x + v / x) >> 1;
+		if (y >= x)
+			return x;
+		x = y;
+	}
+}
+
+float FixedMath::sqrt(float x)
+{
+	if (!(x > 0.f))
+		return 0.f;
+
+	uint32_t bits;
+	std::memcpy(&bits, &x, sizeof(bits));
+	int exponent = (bits >> 23) & 0xff;
+	// denormals are as good as zero here
+	if (exponent == 0)
+		return 0.f;
+	if (exponent == 0xff)
+		return x;
+
+	// x = mantissa * 2^exponent with a 24 bit mantissa
+	uint64_t mantissa = (bits & 0x7fffff) | 0x800000;
+	exponent -= 127 + 23;
+	if (exponent & 1)
+	{
+		mantissa <<= 1;
+		exponent -= 1;
+	}
+
+	// sqrt(mantissa) with 12 extra bits, scaling by powers of two is exact
+	return ldexpf((float)isqrt49(mantissa << 24), exponent / 2 - 12);
+}
+
+// angle in radians to a phase where 2^32 is a full turn
+static uint32_t to_phase(float x)
+{
+	double turns = x * (1.0 / (2.0 * M_PI));
+	turns -= std::floor(turns);
+	return (uint32_t)(int64_t)(turns * 4294967296.0);
+}
+
+// sine of a phase in Q30
+static int32_t sin_phase(uint32_t phase)
+{
+	uint32_t quadrant = phase >> 30;
+	uint32_t p = phase & 0x3fffffff;
+	// mirror the second and fourth quadrants
+	if (quadrant & 1)
+		p = 0x40000000 - p;
+
+	uint32_t i = p >> 22;
+	uint32_t frac = (p >> 6) & 0xffff;
+	int32_t a = sin_table[i];
+	int32_t b = i < 256 ? sin_table[i + 1] : a;
+	int32_t v = a + (int32_t)(((int64_t)(b - a) * frac) >> 16);
+
+	return quadrant & 2 ? -v : v;
+}
+
+float FixedMath::sin(float x)
+{
+	return sin_phase(to_phase(x)) * q30_to_float;
+}
+
+float FixedMath::cos(float x)
+{
+	// a quarter turn ahead
+	return sin_phase(to_phase(x) + 0x40000000u) * q30_to_float;
+}
+
+float FixedMath::atan2(float y, float x)
+{
+	if (x == 0.f && y == 0.f)
+		return 0.f;
+
+	float ax = std::fabs(x);
+	float ay = std::fabs(y);
+	bool steep = ay > ax;
+	// in [0, 1] so it fits the table
+	float t = steep ? ax / ay : ay / ax;
+
+	uint32_t q = (uint32_t)(t * 16777216.f);
+	uint32_t i = q >> 16;
+	uint32_t frac = q & 0xffff;
+	int64_t a = atan_table[i];
+	int64_t b = i < 256 ? atan_table[i + 1] : a;
+	int64_t v = a + (((b - a) * frac) >> 16);
+
+	if (steep)
+		v = half_pi_q30 - v;
+	if (x < 0.f)
+		v = pi_q30 - v;
+	if (y < 0.f)
+		v = -v;
+
+	return v * (double)q30_to_float;
+}
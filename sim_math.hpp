@@ -0,0 +1,72 @@
+#ifndef SIM_MATH_HPP
+#define SIM_MATH_HPP
+
+#include <cmath>
+#include <cstdint>
+
+// Math backends for the simulation. Basic float arithmetic is IEEE on every
+// x86-64 target we build for (as long as nothing gets fused into FMAs), but
+// sqrtf/sinf/cosf/atan2f come from whatever C library is linked and don't
+// round the same everywhere. Build with FIXED_MATH=1 to swap them for integer
+// implementations that produce the same bits on every machine.
+
+// the C library, fast but not reproducible between platforms
+struct FloatMath
+{
+	static inline float sqrt(float x)
+	{
+		return sqrtf(x);
+	}
+
+	static inline float sin(float x)
+	{
+		return sinf(x);
+	}
+
+	static inline float cos(float x)
+	{
+		return cosf(x);
+	}
+
+	static inline float atan2(float y, float x)
+	{
+		return atan2f(y, x);
+	}
+};
+
+// fixed point: integer square root, table driven trig
+struct FixedMath
+{
+	static float sqrt(float x);
+	static float sin(float x);
+	static float cos(float x);
+	static float atan2(float y, float x);
+};
+
+#ifdef CLIMB_FIXED_MATH
+typedef FixedMath SimMath;
+#else
+typedef FloatMath SimMath;
+#endif
+
+// xorshift32, unlike rand() the sequence is the same with every C library
+class SimRandom
+{
+	uint32_t state = 2463534242u;
+public:
+	inline void seed(uint32_t s)
+	{
+		// zero would get stuck
+		state = s ? s : 2463534242u;
+	}
+
+	inline uint32_t next()
+	{
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state;
+	}
+};
+
+#endif
@@ -0,0 +1,176 @@
+#define _USE_MATH_DEFINES
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "sound.hpp"
+
+static const char* sfx_names[SFX_COUNT] = {"grapple", "let_go", "death", "revive"};
+
+static const unsigned int sample_rate = 44100;
+
+// simple procedural stand-ins for when the sound files are missing
+static void synthesize(Sfx effect, std::vector<sf::Int16>& samples)
+{
+	float length = 0.f;
+	switch (effect)
+	{
+		case SFX_GRAPPLE:
+			length = 0.12f;
+			break;
+		case SFX_LET_GO:
+			length = 0.15f;
+			break;
+		case SFX_DEATH:
+			length = 0.6f;
+			break;
+		case SFX_REVIVE:
+			length = 0.3f;
+			break;
+		default:
+			break;
+	}
+
+	unsigned int count = length * sample_rate;
+	samples.resize(count);
+
+	float phase = 0.f;
+	uint32_t noise = 22222;
+	for (unsigned int i = 0; i < count; ++i)
+	{
+		float t = i / (float)count;
+		float freq = 0.f;
+		float value = 0.f;
+		switch (effect)
+		{
+			case SFX_GRAPPLE:
+				// rising chirp
+				freq = 400.f + 1200.f * t;
+				break;
+			case SFX_LET_GO:
+				// falling chirp
+				freq = 900.f - 600.f * t;
+				break;
+			case SFX_DEATH:
+				// low descending wobble
+				freq = 220.f - 160.f * t + 20.f * sinf(t * 40.f);
+				break;
+			case SFX_REVIVE:
+				// three step arpeggio
+				freq = t < 1.f / 3.f ? 523.f : (t < 2.f / 3.f ? 659.f : 784.f);
+				break;
+			default:
+				break;
+		}
+		phase += 2.f * M_PI * freq / sample_rate;
+		value = sinf(phase);
+
+		if (effect == SFX_LET_GO)
+		{
+			noise = noise * 1103515245 + 12345;
+			value = value * 0.5f + ((noise >> 16) / 32768.f - 1.f) * 0.5f;
+		}
+
+		// short attack, linear release
+		float envelope = std::min(1.f, t * 50.f) * (1.f - t);
+		samples[i] = (sf::Int16)(value * envelope * 12000.f);
+	}
+}
+
+void SoundBoard::load()
+{
+	std::vector<sf::Int16> samples;
+	for (unsigned int e = 0; e < SFX_COUNT; ++e)
+	{
+		std::string file = std::string {"sfx/"} + sfx_names[e] + ".wav";
+		if (!buffers[e].loadFromFile(file))
+		{
+			synthesize((Sfx)e, samples);
+			if (!buffers[e].loadFromSamples(samples.data(), samples.size(), 1, sample_rate))
+				continue;
+		}
+
+		for (auto& voice : voices[e])
+			voice.sound.setBuffer(buffers[e]);
+		enabled[e] = true;
+	}
+}
+
+void SoundBoard::play(Sfx effect)
+{
+	if (!enabled[effect])
+		return;
+
+	sf::Int64 now = clock.getElapsedTime().asMicroseconds();
+
+	// find a free voice or steal the oldest one
+	Voice* voice = nullptr;
+	for (auto& v : voices[effect])
+	{
+		if (v.sound.getStatus() == sf::SoundSource::Stopped)
+		{
+			voice = &v;
+			break;
+		}
+		if (voice == nullptr || v.started < voice->started)
+			voice = &v;
+	}
+	if (voice->sound.getStatus() != sf::SoundSource::Stopped)
+	{
+		++steals;
+		voice->sound.stop();
+	}
+
+	voice->sound.play();
+	voice->started = ++triggers;
+	voice->cue_time = now;
+
+	sf::Int64 cost = clock.getElapsedTime().asMicroseconds() - now;
+	if (cost > trigger_max)
+		trigger_max = cost;
+}
+
+void SoundBoard::update()
+{
+	sf::Int64 now = clock.getElapsedTime().asMicroseconds();
+	for (auto& effect_voices : voices)
+	{
+		for (auto& voice : effect_voices)
+		{
+			if (voice.cue_time < 0)
+				continue;
+
+			// finished before we got to look at it, can't tell
+			if (voice.sound.getStatus() == sf::SoundSource::Stopped)
+			{
+				voice.cue_time = -1;
+				continue;
+			}
+
+			// once the mixer has consumed some samples, whatever time isn't accounted for by them was latency
+			sf::Int64 played = voice.sound.getPlayingOffset().asMicroseconds();
+			if (played <= 0)
+				continue;
+
+			sf::Int64 latency = now - voice.cue_time - played;
+			if (latency < 0)
+				latency = 0;
+			++latency_samples;
+			latency_total += latency;
+			if (latency > latency_max)
+				latency_max = latency;
+			voice.cue_time = -1;
+		}
+	}
+}
+
+void SoundBoard::report(std::ostream& out) const
+{
+	if (triggers == 0)
+		return;
+
+	out << "Sound effects: " << triggers << " played, " << steals << " voices stolen, trigger cost max " << trigger_max << " us";
+	if (latency_samples)
+		out << ", cue latency avg " << latency_total / latency_samples / 1000.f << " ms max " << latency_max / 1000.f << " ms";
+	out << std::endl;
+}
@@ -0,0 +1,60 @@
+#ifndef SOUND_HPP
+#define SOUND_HPP
+
+#include <cstdint>
+#include <ostream>
+
+#include <SFML/Audio.hpp>
+
+enum Sfx
+{
+	SFX_GRAPPLE,
+	SFX_LET_GO,
+	SFX_DEATH,
+	SFX_REVIVE,
+	SFX_COUNT
+};
+
+// Sound effects decoded once at startup and played through a fixed pool of
+// voices. Each effect owns its own voices so triggering one never rebinds a
+// buffer (which would allocate in SFML); when they are all busy the oldest
+// one is restarted.
+class SoundBoard
+{
+	static const unsigned int voices_per_effect = 3;
+
+	struct Voice
+	{
+		sf::Sound sound;
+		// trigger order, for stealing the oldest voice
+		uint64_t started = 0;
+		// when play() was called, or -1 once latency has been measured
+		sf::Int64 cue_time = -1;
+	};
+
+	sf::SoundBuffer buffers[SFX_COUNT];
+	Voice voices[SFX_COUNT][voices_per_effect];
+	bool enabled[SFX_COUNT] = {};
+
+	uint64_t triggers = 0;
+	unsigned int steals = 0;
+
+	sf::Clock clock;
+	// cue latency: time from play() until samples are actually coming out
+	unsigned int latency_samples = 0;
+	sf::Int64 latency_total = 0;
+	sf::Int64 latency_max = 0;
+	sf::Int64 trigger_max = 0;
+public:
+	// load sfx/<name>.wav, falling back to a synthesized effect
+	void load();
+
+	void play(Sfx effect);
+
+	// measure latency of recently cued voices, call once per frame
+	void update();
+
+	void report(std::ostream& out) const;
+};
+
+#endif
@@ -0,0 +1,357 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "spectate.hpp"
+
+#ifndef MSG_NOSIGNAL
+// macOS, SO_NOSIGPIPE is set on each client instead
+#define MSG_NOSIGNAL 0
+#endif
+
+SpectateServer::SpectateServer()
+{
+	points.reserve(1024);
+	last_points.reserve(1024);
+	moving.reserve(1024);
+	message.reserve(max_pending);
+	for (auto& client : clients)
+		client.pending.reserve(max_pending);
+}
+
+SpectateServer::~SpectateServer()
+{
+	close();
+}
+
+int16_t SpectateServer::quantize(float v, float origin) const
+{
+	float q = std::round((v - origin) * spectate_scale);
+	if (q > 32767.f)
+		return 32767;
+	if (q < -32768.f)
+		return -32768;
+	return (int16_t)q;
+}
+
+#ifdef _WIN32
+
+bool SpectateServer::open(const std::string&)
+{
+	return false;
+}
+
+void SpectateServer::close()
+{
+}
+
+void SpectateServer::accept_clients()
+{
+}
+
+void SpectateServer::drop(unsigned int)
+{
+}
+
+bool SpectateServer::flush(Client&, const char*, std::size_t)
+{
+	return false;
+}
+
+#else
+
+bool SpectateServer::open(const std::string& path)
+{
+	close();
+
+	sockaddr_un addr {};
+	addr.sun_family = AF_UNIX;
+	if (path.size() >= sizeof(addr.sun_path))
+		return false;
+	std::strcpy(addr.sun_path, path.c_str());
+
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0)
+		return false;
+
+	// left behind if the game crashed
+	unlink(path.c_str());
+
+	if (bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, max_clients) < 0 || fcntl(fd, F_SETFL, O_NONBLOCK) < 0)
+	{
+		::close(fd);
+		return false;
+	}
+
+	listen_fd = fd;
+	socket_path = path;
+	return true;
+}
+
+void SpectateServer::close()
+{
+	while (client_count)
+		drop(0);
+	if (listen_fd >= 0)
+	{
+		::close(listen_fd);
+		unlink(socket_path.c_str());
+		listen_fd = -1;
+	}
+}
+
+void SpectateServer::accept_clients()
+{
+	int fd;
+	while ((fd = accept(listen_fd, nullptr, nullptr)) >= 0)
+	{
+		if (client_count == max_clients || fcntl(fd, F_SETFL, O_NONBLOCK) < 0)
+		{
+			::close(fd);
+			continue;
+		}
+#ifdef SO_NOSIGPIPE
+		int on = 1;
+		setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+		Client& client = clients[client_count++];
+		client.fd = fd;
+		client.pending.clear();
+		// everyone gets a keyframe, simpler than a separate stream per client
+		keyframe = true;
+		++joined;
+	}
+}
+
+void SpectateServer::drop(unsigned int i)
+{
+	::close(clients[i].fd);
+	--client_count;
+	// keep the live clients packed at the front
+	std::swap(clients[i], clients[client_count]);
+	clients[client_count].fd = -1;
+}
+
+bool SpectateServer::flush(Client& client, const char* data, std::size_t size)
+{
+	// anything already queued has to go first
+	if (!client.pending.empty())
+	{
+		if (client.pending.size() + size > max_pending)
+			return false;
+		client.pending.insert(client.pending.end(), data, data + size);
+		data = client.pending.data();
+		size = client.pending.size();
+	}
+
+	std::size_t sent = 0;
+	while (sent < size)
+	{
+		ssize_t n = ::send(client.fd, data + sent, size - sent, MSG_DONTWAIT | MSG_NOSIGNAL);
+		if (n < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				break;
+			// disconnected
+			return false;
+		}
+		sent += n;
+	}
+
+	if (!client.pending.empty())
+	{
+		client.pending.erase(client.pending.begin(), client.pending.begin() + sent);
+	}
+	else if (sent < size)
+	{
+		if (size - sent > max_pending)
+			return false;
+		client.pending.assign(data + sent, data + size);
+	}
+	bytes += sent;
+	return true;
+}
+
+#endif
+
+bool SpectateServer::begin(uint32_t tick, const sf::Vector2f& camera, double origin_offset)
+{
+	if (listen_fd < 0)
+		return false;
+
+	accept_clients();
+	if (client_count == 0)
+		return false;
+
+	clock.restart();
+
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, spectate_magic, sizeof(header.magic));
+	header.tick = tick;
+	header.camera_x = (int32_t)std::round(camera.x * spectate_scale);
+	header.camera_y = (int32_t)std::round((camera.y - origin_offset) * spectate_scale);
+	camera_x = camera.x;
+	camera_y = camera.y;
+
+	player_count = 0;
+	points.clear();
+	moving.clear();
+	return true;
+}
+
+void SpectateServer::player(const sf::Vector2f& pos, uint32_t target, int8_t lives, uint8_t state)
+{
+	if (player_count == max_players)
+		return;
+
+	PlayerState& p = players[player_count++];
+	p.x = quantize(pos.x, camera_x);
+	p.y = quantize(pos.y, camera_y);
+	p.target = target;
+	p.lives = lives;
+	p.state = state;
+}
+
+void SpectateServer::point(uint32_t id, const sf::Vector2f& pos, bool moves)
+{
+	points.push_back(SpectatePoint {id, quantize(pos.x, camera_x), quantize(pos.y, camera_y)});
+	moving.push_back(moves);
+}
+
+template <typename T>
+static void append(std::vector<char>& out, const T& value)
+{
+	const char* p = (const char*)&value;
+	out.insert(out.end(), p, p + sizeof(value));
+}
+
+void SpectateServer::send()
+{
+	message.resize(sizeof(SpectateHeader));
+
+	header.players = player_count;
+	for (unsigned int i = 0; i < player_count; ++i)
+	{
+		const PlayerState& p = players[i];
+		const PlayerState& last = last_players[i];
+		uint8_t fields = SPECTATE_POSITION | SPECTATE_TARGET | SPECTATE_LIVES | SPECTATE_STATE;
+		if (!keyframe)
+		{
+			fields = 0;
+			if (p.x != last.x || p.y != last.y)
+				fields |= SPECTATE_POSITION;
+			if (p.target != last.target)
+				fields |= SPECTATE_TARGET;
+			if (p.lives != last.lives)
+				fields |= SPECTATE_LIVES;
+			if (p.state != last.state)
+				fields |= SPECTATE_STATE;
+		}
+
+		append(message, (uint8_t)i);
+		append(message, fields);
+		if (fields & SPECTATE_POSITION)
+		{
+			append(message, p.x);
+			append(message, p.y);
+		}
+		if (fields & SPECTATE_TARGET)
+			append(message, p.target);
+		if (fields & SPECTATE_LIVES)
+			append(message, p.lives);
+		if (fields & SPECTATE_STATE)
+			append(message, p.state);
+		last_players[i] = p;
+	}
+
+	// both lists are sorted by id, so one merge finds what came and went
+	std::size_t a = 0, b = 0;
+	while (a < points.size())
+	{
+		if (!keyframe && b < last_points.size() && last_points[b].id < points[a].id)
+		{
+			++b;
+			continue;
+		}
+		if (keyframe || b == last_points.size() || last_points[b].id != points[a].id)
+		{
+			append(message, points[a]);
+			++header.added;
+		}
+		else
+		{
+			if (moving[a])
+			{
+				append(message, points[a]);
+				++header.added;
+			}
+			++b;
+		}
+		++a;
+	}
+
+	if (!keyframe)
+	{
+		a = 0;
+		for (b = 0; b < last_points.size(); ++b)
+		{
+			while (a < points.size() && points[a].id < last_points[b].id)
+				++a;
+			if (a == points.size() || points[a].id != last_points[b].id)
+			{
+				append(message, last_points[b].id);
+				++header.removed;
+			}
+		}
+	}
+	std::swap(points, last_points);
+
+	if (keyframe)
+	{
+		header.flags |= SPECTATE_KEYFRAME;
+		++keyframes;
+	}
+	header.size = message.size();
+	std::memcpy(message.data(), &header, sizeof(header));
+	keyframe = false;
+
+	sf::Int64 us = clock.getElapsedTime().asMicroseconds();
+	encode_total += us;
+	encoded += message.size();
+	if (us > encode_max)
+		encode_max = us;
+	++messages;
+
+	for (unsigned int i = 0; i < client_count;)
+	{
+		if (flush(clients[i], message.data(), message.size()))
+		{
+			++i;
+		}
+		else
+		{
+			drop(i);
+			++dropped;
+		}
+	}
+}
+
+void SpectateServer::report(std::ostream& out) const
+{
+	if (messages == 0)
+		return;
+
+	out << "Spectators: " << joined << " joined, " << dropped << " left or fell behind, " << messages << " ticks streamed (" << keyframes << " keyframes), "
+		<< (float)encoded / messages << " bytes per tick (" << encoded * 60.f / messages / 1024.f << " KiB/s at 60 Hz), "
+		<< bytes << " bytes sent in total, encode avg " << (float)encode_total / messages << " us max " << encode_max << " us" << std::endl;
+}
@@ -0,0 +1,161 @@
+#ifndef SPECTATE_HPP
+#define SPECTATE_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <SFML/System.hpp>
+
+// Live game state for spectators, published over a Unix domain socket.
+//
+// Every tick each connected spectator gets one message: a SpectateHeader,
+// then `players` player updates, `added` SpectatePoints and `removed` point
+// ids (uint32_t). A point that moves is added again, with the same id, every
+// tick it's moving. A player update is a uint8_t index and a uint8_t mask of
+// SPECTATE_* bits saying which of these fields follow, in this order:
+// int16_t x, int16_t y, uint32_t target, int8_t lives, uint8_t state.
+// Only what changed since the previous message is sent, except in a
+// keyframe, which carries everything and goes out whenever someone joins.
+//
+// Positions are in quarter pixels relative to the camera center. The camera
+// itself is in quarter pixels from where the world started, so rebasing the
+// origin doesn't show up in the stream. Everything is little-endian.
+
+const char spectate_magic[4] = {'C', 'L', 'S', '1'};
+
+struct SpectateHeader
+{
+	char magic[4];
+	// of the whole message, header included
+	uint32_t size;
+	uint32_t tick;
+	int32_t camera_x;
+	int32_t camera_y;
+	uint16_t added;
+	uint16_t removed;
+	uint8_t flags;
+	uint8_t players;
+	uint16_t reserved;
+};
+
+static_assert(sizeof(SpectateHeader) == 28, "spectate header layout changed");
+
+struct SpectatePoint
+{
+	uint32_t id;
+	int16_t x;
+	int16_t y;
+};
+
+static_assert(sizeof(SpectatePoint) == 8, "spectate point layout changed");
+
+// header flags
+enum : uint8_t
+{
+	SPECTATE_KEYFRAME = 1,
+};
+
+// player update fields
+enum : uint8_t
+{
+	SPECTATE_POSITION = 1,
+	SPECTATE_TARGET = 2,
+	SPECTATE_LIVES = 4,
+	SPECTATE_STATE = 8,
+};
+
+// grapple targets: 0 for none, a point id, or this bit plus a player index
+const uint32_t spectate_player_target = 0x80000000u;
+
+// quarter pixels per pixel
+const float spectate_scale = 4.f;
+
+// Game side of the stream. Call begin() every tick; only if it returns true
+// (someone is watching) describe the players and points and call send().
+// Nothing here ever blocks: a spectator that can't keep up is dropped.
+class SpectateServer
+{
+	static const unsigned int max_clients = 8;
+	static const unsigned int max_players = 8;
+	// queued bytes per client before it is considered too slow
+	static const std::size_t max_pending = 65536;
+
+	struct Client
+	{
+		int fd = -1;
+		std::vector<char> pending;
+	};
+
+	struct PlayerState
+	{
+		int16_t x;
+		int16_t y;
+		uint32_t target;
+		int8_t lives;
+		uint8_t state;
+	};
+
+	int listen_fd = -1;
+	std::string socket_path;
+	Client clients[max_clients];
+	unsigned int client_count = 0;
+	bool keyframe = false;
+
+	SpectateHeader header;
+	float camera_x = 0.f;
+	float camera_y = 0.f;
+	PlayerState players[max_players];
+	PlayerState last_players[max_players];
+	unsigned int player_count = 0;
+	// sorted by id
+	std::vector<SpectatePoint> points;
+	std::vector<SpectatePoint> last_points;
+	// whether each of points is resent every tick
+	std::vector<uint8_t> moving;
+	std::vector<char> message;
+
+	sf::Clock clock;
+	uint64_t messages = 0;
+	uint64_t keyframes = 0;
+	// message bytes, and bytes actually written to all spectators
+	uint64_t encoded = 0;
+	uint64_t bytes = 0;
+	unsigned int joined = 0;
+	unsigned int dropped = 0;
+	sf::Int64 encode_total = 0;
+	sf::Int64 encode_max = 0;
+
+	void accept_clients();
+	void drop(unsigned int i);
+	// write as much as the socket takes, false if the client has to go
+	bool flush(Client& client, const char* data, std::size_t size);
+	int16_t quantize(float v, float origin) const;
+public:
+	SpectateServer();
+	SpectateServer(const SpectateServer&) = delete;
+	SpectateServer& operator=(const SpectateServer&) = delete;
+	~SpectateServer();
+
+	// listen on a Unix socket at path, replacing any stale one
+	bool open(const std::string& path);
+	void close();
+
+	inline bool is_open() const
+	{
+		return listen_fd >= 0;
+	}
+
+	// start a tick's message, returns false (and does nothing else) if no one is watching
+	bool begin(uint32_t tick, const sf::Vector2f& camera, double origin_offset);
+	void player(const sf::Vector2f& pos, uint32_t target, int8_t lives, uint8_t state);
+	// points have to be given in increasing id order
+	void point(uint32_t id, const sf::Vector2f& pos, bool moves = false);
+	// diff against the last message and send to everyone watching
+	void send();
+
+	void report(std::ostream& out) const;
+};
+
+#endif
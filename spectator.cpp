@@ -0,0 +1,382 @@
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <vector>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include <SFML/Graphics.hpp>
+
+#include "draw.hpp"
+#include "spectate.hpp"
+#include "telemetry.hpp"
+
+// Lobby display for a running game, fed by `climb --spectate SOCKET`.
+
+const unsigned int winw = 1600;
+const unsigned int winh = 900;
+
+struct Player
+{
+	sf::Vector2f offset;
+	uint32_t target = 0;
+	int8_t lives = 0;
+	uint8_t state = 0;
+};
+
+class Spectator
+{
+	int fd = -1;
+	std::vector<char> buffer;
+	bool synced = false;
+
+	// apply one complete message, false if it is garbage
+	bool apply(const char* data, std::size_t size);
+public:
+	sf::Vector2f camera;
+	std::vector<Player> players;
+	// world positions in pixels, by id
+	std::map<uint32_t, sf::Vector2f> points;
+	uint64_t bytes = 0;
+
+	~Spectator()
+	{
+		disconnect();
+	}
+
+	bool connected() const
+	{
+		return fd >= 0;
+	}
+
+	bool connect(const std::string& path);
+	void disconnect();
+	// read whatever has arrived, never blocks
+	void poll();
+
+	sf::Vector2f player_pos(unsigned int i) const
+	{
+		return camera + players[i].offset;
+	}
+
+	// where a grapple target is, false if it's gone
+	bool target_pos(uint32_t target, sf::Vector2f& pos) const;
+};
+
+#ifdef _WIN32
+
+bool Spectator::connect(const std::string&)
+{
+	return false;
+}
+
+void Spectator::disconnect()
+{
+}
+
+void Spectator::poll()
+{
+}
+
+#else
+
+bool Spectator::connect(const std::string& path)
+{
+	sockaddr_un addr {};
+	addr.sun_family = AF_UNIX;
+	if (path.size() >= sizeof(addr.sun_path))
+		return false;
+	std::strcpy(addr.sun_path, path.c_str());
+
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0)
+		return false;
+	if (::connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0 || fcntl(fd, F_SETFL, O_NONBLOCK) < 0)
+	{
+		disconnect();
+		return false;
+	}
+	return true;
+}
+
+void Spectator::disconnect()
+{
+	if (fd >= 0)
+		close(fd);
+	fd = -1;
+	buffer.clear();
+	synced = false;
+}
+
+void Spectator::poll()
+{
+	char chunk[65536];
+	while (fd >= 0)
+	{
+		ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			break;
+		if (n <= 0)
+		{
+			disconnect();
+			return;
+		}
+		buffer.insert(buffer.end(), chunk, chunk + n);
+		bytes += n;
+	}
+
+	std::size_t used = 0;
+	while (buffer.size() - used >= sizeof(SpectateHeader))
+	{
+		SpectateHeader header;
+		std::memcpy(&header, buffer.data() + used, sizeof(header));
+		if (std::memcmp(header.magic, spectate_magic, sizeof(header.magic)) || header.size < sizeof(header))
+		{
+			std::cerr << "Bad spectator message\n";
+			disconnect();
+			return;
+		}
+		if (buffer.size() - used < header.size)
+			break;
+		if (!apply(buffer.data() + used, header.size))
+		{
+			std::cerr << "Bad spectator message\n";
+			disconnect();
+			return;
+		}
+		used += header.size;
+	}
+	buffer.erase(buffer.begin(), buffer.begin() + used);
+}
+
+#endif
+
+template <typename T>
+static bool read(const char*& data, const char* end, T& value)
+{
+	if (end - data < (std::ptrdiff_t)sizeof(value))
+		return false;
+	std::memcpy(&value, data, sizeof(value));
+	data += sizeof(value);
+	return true;
+}
+
+bool Spectator::apply(const char* data, std::size_t size)
+{
+	const char* end = data + size;
+	SpectateHeader header;
+	read(data, end, header);
+
+	// deltas are meaningless until we've seen everything once
+	if (header.flags & SPECTATE_KEYFRAME)
+	{
+		synced = true;
+		points.clear();
+	}
+	if (!synced)
+		return true;
+
+	camera = sf::Vector2f {header.camera_x / spectate_scale, header.camera_y / spectate_scale};
+	players.resize(header.players);
+
+	for (unsigned int i = 0; i < header.players; ++i)
+	{
+		uint8_t index, fields;
+		if (!read(data, end, index) || !read(data, end, fields) || index >= players.size())
+			return false;
+		Player& player = players[index];
+		if (fields & SPECTATE_POSITION)
+		{
+			int16_t x, y;
+			if (!read(data, end, x) || !read(data, end, y))
+				return false;
+			player.offset = sf::Vector2f {x / spectate_scale, y / spectate_scale};
+		}
+		if ((fields & SPECTATE_TARGET) && !read(data, end, player.target))
+			return false;
+		if ((fields & SPECTATE_LIVES) && !read(data, end, player.lives))
+			return false;
+		if ((fields & SPECTATE_STATE) && !read(data, end, player.state))
+			return false;
+	}
+
+	for (unsigned int i = 0; i < header.added; ++i)
+	{
+		SpectatePoint point;
+		if (!read(data, end, point))
+			return false;
+		points[point.id] = camera + sf::Vector2f {point.x / spectate_scale, point.y / spectate_scale};
+	}
+
+	for (unsigned int i = 0; i < header.removed; ++i)
+	{
+		uint32_t id;
+		if (!read(data, end, id))
+			return false;
+		points.erase(id);
+	}
+
+	return data == end;
+}
+
+bool Spectator::target_pos(uint32_t target, sf::Vector2f& pos) const
+{
+	if (target & spectate_player_target)
+	{
+		unsigned int i = target & ~spectate_player_target;
+		if (i >= players.size())
+			return false;
+		pos = player_pos(i);
+		return true;
+	}
+
+	auto point = points.find(target);
+	if (point == points.end())
+		return false;
+	pos = point->second;
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	std::string path = "climb.spectate";
+	if (argc == 2)
+		path = argv[1];
+	else if (argc > 2)
+	{
+		std::cerr << "Usage: " << argv[0] << " [SOCKET]\n";
+		return 1;
+	}
+
+	sf::RenderWindow window {sf::VideoMode {winw, winh}, "Viking Climb - Spectator"};
+	window.setVerticalSyncEnabled(true);
+
+	sf::Texture avatar_tex, point_tex;
+	if (!avatar_tex.loadFromFile("img/player.png") || !point_tex.loadFromFile("img/point.png"))
+	{
+		std::cerr << "Failed to load textures\n";
+		return 1;
+	}
+
+	sf::Font font;
+	font.loadFromFile("/usr/share/fonts/TTF/DejaVuSansMono.ttf");
+	sf::Text status;
+	status.setFont(font);
+	status.setCharacterSize(20);
+	status.setPosition(10.f, winh - 30.f);
+
+	const sf::Color colors[2] = {sf::Color {45, 185, 210}, sf::Color {53, 152, 38}};
+
+	sf::Sprite avatar {avatar_tex};
+	auto s = avatar_tex.getSize();
+	avatar.setOrigin(s.x / 2.f, s.y / 2.f);
+
+	sf::Sprite point_sprite {point_tex};
+	s = point_tex.getSize();
+	point_sprite.setOrigin(s.x / 2.f, s.y / 2.f);
+	point_sprite.setScale(4.f, 4.f);
+
+	sf::VertexArray ropes {sf::Lines};
+
+	Spectator spectator;
+	sf::Clock retry;
+	sf::Clock rate_clock;
+	uint64_t rate_bytes = 0;
+	float rate = 0.f;
+
+	while (window.isOpen())
+	{
+		sf::Event event;
+		while (window.pollEvent(event))
+		{
+			if (event.type == sf::Event::Closed || (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Escape))
+				window.close();
+		}
+
+		if (!spectator.connected() && retry.getElapsedTime().asSeconds() > 1.f)
+		{
+			retry.restart();
+			spectator.connect(path);
+		}
+		spectator.poll();
+
+		if (rate_clock.getElapsedTime().asSeconds() > 1.f)
+		{
+			rate = (spectator.bytes - rate_bytes) / rate_clock.restart().asSeconds();
+			rate_bytes = spectator.bytes;
+		}
+
+		window.clear(sf::Color {40, 20, 20});
+
+		sf::View view {spectator.camera, sf::Vector2f {(float)winw, (float)winh}};
+		window.setView(view);
+
+		for (auto& point : spectator.points)
+		{
+			point_sprite.setPosition(point.second);
+			draw(window, point_sprite);
+		}
+
+		ropes.clear();
+		for (unsigned int i = 0; i < spectator.players.size(); ++i)
+		{
+			sf::Vector2f target;
+			if (spectator.players[i].target && spectator.target_pos(spectator.players[i].target, target))
+			{
+				sf::Color color = colors[i % 2];
+				ropes.append(sf::Vertex {spectator.player_pos(i), color});
+				ropes.append(sf::Vertex {target, color});
+			}
+		}
+		draw(window, ropes);
+
+		for (unsigned int i = 0; i < spectator.players.size(); ++i)
+		{
+			const Player& player = spectator.players[i];
+			sf::Color color = colors[i % 2];
+			if (player.state & TELEMETRY_DEAD)
+				color.a = 80;
+			avatar.setColor(color);
+			avatar.setScale(4.f * (i == 1 ? -1.f : 1.f), 4.f);
+			avatar.setPosition(spectator.player_pos(i));
+			draw(window, avatar);
+		}
+
+		// lives along the top, like in the game
+		window.setView(window.getDefaultView());
+		for (unsigned int i = 0; i < spectator.players.size() && i < 2; ++i)
+		{
+			avatar.setColor(colors[i]);
+			avatar.setScale(4.f * (i == 1 ? -1.f : 1.f), 4.f);
+			for (int l = 0; l < spectator.players[i].lives; ++l)
+			{
+				avatar.setPosition(sf::Vector2f{i * winw - (30.f + l * 60.f) * (2 * i - 1), 30.f});
+				draw(window, avatar);
+			}
+		}
+
+		if (spectator.connected())
+		{
+			char line[32];
+			std::snprintf(line, sizeof(line), "%.1f KiB/s", rate / 1024.f);
+			status.setString(line);
+		}
+		else
+			status.setString("Waiting for " + path);
+		draw(window, status);
+
+		window.display();
+		draw_calls = 0;
+	}
+
+	return 0;
+}
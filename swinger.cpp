@@ -0,0 +1,498 @@
+#include <algorithm>
+#include <cmath>
+
+#include "draw.hpp"
+#include "spectate.hpp"
+#include "swinger.hpp"
+#include "telemetry.hpp"
+
+unsigned int Swinger::targets_version = 0;
+uint64_t Swinger::aim_calls = 0;
+uint64_t Swinger::aim_hits = 0;
+
+Swinger::Swinger(int i, const std::string& nm, SoundBoard& sfx, SpeechBubbles& speech, SwingerPhysics& phys, RopePhysics& rope_phys, float x, const sf::Color& color, const sf::Texture& avatar_tex, const sf::Texture& reticle_tex,  const sf::Texture& aimbox_tex, const sf::Texture& rope_tex)
+	: Grappable {x, 0.f}, name {nm}, sounds {sfx}, bubbles {speech}, physics {phys}, ropes {rope_phys}, avatar {avatar_tex}, reticle {reticle_tex}, aimbox {aimbox_tex}, rope {rope_tex}
+{
+	index = i;
+	grappable_id = spectate_player_target | i;
+	auto s = avatar_tex.getSize();
+	float scale = 4.f;
+	half_height = s.y * scale / 2.f;
+	half_width = s.x * scale / 2.f;
+	position.y = floor_y - half_height;
+	body = physics.add(position.x, position.y, half_width, half_height);
+	rope_index = ropes.add();
+
+	avatar.setOrigin(s.x / 2.f, s.y / 2.f);
+	avatar.setScale(scale * (index == 1 ? -1.f : 1.f), scale);
+	avatar.setColor(color);
+
+	s = reticle_tex.getSize();
+	reticle.setOrigin(s.x / 2.f, s.y / 2.f);
+	reticle.setScale(scale, scale);
+	reticle.setColor(color);
+
+	s = aimbox_tex.getSize();
+	aimbox.setOrigin(s.x / -2.f, s.y / 2.f);
+	aimbox.setScale(scale, scale);
+	aimbox.setColor(sf::Color {color.r, color.g, color.b, 100});
+
+	s = rope_tex.getSize();
+	rope.setOrigin(0.f, s.y / 2.f);
+	rope.setColor(sf::Color {(sf::Uint8)(color.r / 3), (sf::Uint8)(color.g / 3), (sf::Uint8)(color.b / 3)});
+
+	max_target_dist2 = max_target_dist * max_target_dist;
+
+	bubble_sprite.setTexture(bubbles.texture());
+	bubble_sprite.setOrigin(5.f, 5.f);
+	bubbles.style(textbox, textboxbox);
+	textarrow.setPointCount(3);
+	textarrow.setPoint(0, sf::Vector2f {0.f, 10.f});
+	textarrow.setPoint(1, sf::Vector2f {1.f, 0.f});
+	textarrow.setPoint(2, sf::Vector2f {0.f, -10.f});
+	textarrow.setFillColor(sf::Color::White);
+	textarrow.setOrigin(0.f, 5.f);
+}
+
+void Swinger::say(const sf::String& txt, float time)
+{
+	bubble = bubbles.get(txt);
+	if (bubble)
+	{
+		textbounds = bubble->bounds;
+		bubble_sprite.setTextureRect(bubble->rect);
+	}
+	else
+	{
+		textbox.setString(txt);
+		textbounds = textbox.getLocalBounds();
+		textboxbox.setSize(sf::Vector2f{textbounds.width + 20.f, textbounds.height + 20.f});
+	}
+	text_end_tick = game_tick + (unsigned int)(time * 1000.f / game_step);
+}
+
+std::string Swinger::lament_line(const std::string& nm, int r)
+{
+	std::string l;
+	switch (r)
+	{
+		case 0:
+			l = nm + "!? " + nm + "!!!!";
+			break;
+		case 1:
+			l = nm + ", I'LL NEVER LET GO!";
+			break;
+		case 2:
+			l = nm + "! WHY????";
+			break;
+		case 3:
+			l = nm + ", I WILL TELL YOUR FAMILY THAT YOU LOVE THEM!";
+			break;
+		case 4:
+			l = nm + "... HE WAS ONLY TWO DAYS FROM RETIREMENT...";
+			break;
+		case 5:
+			l = "NO! " + nm + "! TAKE ME INSTEAD!";
+			break;
+		case 6:
+			l = "I CAN'T BEAR TO LIVE WITHOUT YOU, " + nm + "!";
+			break;
+		case 7:
+			l = nm + "! HOW DID IT COME TO THIS???";
+			break;
+		case 8:
+			l = "I WILL LOVE YOU FOREVER, " + nm + "!";
+			break;
+		case 9:
+			l = "I MUST BE STRONG. FOR " + nm + "!";
+			break;
+	}
+	return l;
+}
+
+void Swinger::prepare_laments(const std::string& nm)
+{
+	if (nm != lament_name)
+	{
+		lament_name = nm;
+		for (int r = 0; r < lament_count; ++r)
+		{
+			laments[r] = lament_line(nm, r);
+			bubbles.get(laments[r]);
+		}
+	}
+}
+
+void Swinger::lament(const std::string& nm)
+{
+	prepare_laments(nm);
+	say(laments[randm(lament_count)], 3);
+}
+
+uint8_t Swinger::telemetry_state() const
+{
+	uint8_t state = 0;
+	if (physics.grappling[body] == GRAPPLE_PULLING)
+		state |= TELEMETRY_PULLING;
+	else if (physics.grappling[body] == GRAPPLE_SWINGING)
+		state |= TELEMETRY_SWINGING;
+	if (aiming)
+		state |= TELEMETRY_AIMING;
+	if (dead)
+		state |= TELEMETRY_DEAD;
+	if (reviving)
+		state |= TELEMETRY_REVIVING;
+	return state;
+}
+
+void Swinger::die()
+{
+	--lives;
+	release();
+	stop_aim();
+	text_end_tick = 0;
+	dead = true;
+	physics.active[body] = 0;
+	dead_tick = game_tick;
+	sounds.play(SFX_DEATH);
+}
+
+bool Swinger::need_revive() const
+{
+	return dead && lives >= 0 && game_tick - dead_tick > 2000 / game_step;
+}
+
+void Swinger::revive()
+{
+	dead = false;
+	physics.active[body] = 1;
+	reviving = true;
+	sounds.play(SFX_REVIVE);
+}
+
+void Swinger::aim(const sf::Vector2f& dir, const std::vector<Swinger*>& players, const std::vector<Point*>& points, uint32_t points_version, const sf::View& camera)
+{
+	if (dead)
+		return;
+
+	float theta = atan2f(dir.y, dir.x);
+	aimbox.setRotation(rad2deg(theta));
+	aiming = true;
+
+	nearest = nullptr;
+	float ndist2 = -1.f;
+
+	for (auto& player : players)
+	{
+		// can't grapple self
+		if (player == this)
+			continue;
+
+		// can't grapple someone grappling self
+		if (player->target() == this)
+			continue;
+
+		// can't grapple dead players
+		if (player->is_dead())
+			continue;
+
+		// skip players already being grappled
+		bool already_targeted = false;
+		for (auto& player2 : players)
+		{
+			if (player2->target() == player)
+			{
+				already_targeted = true;
+				break;
+			}
+		}
+		if (already_targeted)
+			continue;
+
+		float ldist2 = dist2line(dir, player->pos());
+		if (ldist2 < 0.f)
+			continue;
+
+		if (nearest == nullptr || ldist2 < ndist2)
+		{
+			nearest = player;
+			ndist2 = ldist2;
+		}
+	}
+
+	float top = camera.getCenter().y - camera.getSize().y / 2.f;
+	sf::Vector2f unit = dir / norm(dir);
+
+	++aim_calls;
+	if (!aim_cache_holds(dir, unit, top, points_version))
+	{
+		scan_points(dir, unit, players, points, top, points_version, ndist2);
+		return;
+	}
+	++aim_hits;
+
+	// the nearest still point from the scan, and the moving ones where they are now
+	if (aim_cache.still)
+	{
+		float ldist2 = dist2line(dir, aim_cache.still->pos());
+		if (nearest == nullptr || ldist2 < ndist2)
+		{
+			nearest = aim_cache.still;
+			ndist2 = ldist2;
+		}
+	}
+	for (unsigned int i = 0; i < aim_cache.moving_count; ++i)
+	{
+		Point* point = aim_cache.moving[i];
+		if (point->pos().y < top)
+			continue;
+
+		float ldist2 = dist2line(dir, point->pos());
+		if (ldist2 < 0.f)
+			continue;
+
+		if (nearest == nullptr || ldist2 < ndist2)
+		{
+			nearest = point;
+			ndist2 = ldist2;
+		}
+	}
+}
+
+bool Swinger::aim_cache_holds(const sf::Vector2f& dir, const sf::Vector2f& unit, float top, uint32_t points_version)
+{
+	const AimCache& cache = aim_cache;
+	if (!cache.valid || cache.points_version != points_version || cache.targets_version != targets_version)
+		return false;
+	if (dot(unit, cache.dir) < aim_cache_cos || dist2(position, cache.position) > aim_cache_move * aim_cache_move)
+		return false;
+	// a point has come on screen
+	if (top <= cache.entering)
+		return false;
+	// the nearest went off screen or out of the cone, the next nearest takes a scan
+	if (cache.still && (cache.still->pos().y < top || dist2line(dir, cache.still->pos()) < 0.f))
+		return false;
+	return true;
+}
+
+void Swinger::scan_points(const sf::Vector2f& dir, const sf::Vector2f& unit, const std::vector<Swinger*>& players, const std::vector<Point*>& points, float top, uint32_t points_version, float& ndist2)
+{
+	AimCache& cache = aim_cache;
+	cache.valid = true;
+	cache.dir = unit;
+	cache.position = position;
+	cache.points_version = points_version;
+	cache.targets_version = targets_version;
+	cache.moving_count = 0;
+	// kept in locals until the end, the loop runs faster without stores through this
+	float entering = -INFINITY;
+	Point* still = nullptr;
+	float sdist2 = -1.f;
+	Grappable* best = nearest;
+	float bdist2 = ndist2;
+	// anything this close could be in reach before the cache is rescanned
+	float near_dist = max_target_dist + aim_cache_move;
+
+	for (auto& point : points)
+	{
+		// skip points already being grappled
+		bool already_targeted = false;
+		for (auto& player : players)
+		{
+			if (player->target() == point)
+			{
+				already_targeted = true;
+				break;
+			}
+		}
+		if (already_targeted)
+			continue;
+
+		bool moves = point->moves();
+		if (moves)
+		{
+			// checked every aim while the cache holds
+			float reach = near_dist + point->reach();
+			if (dist2(point->get_anchor(), position) <= reach * reach)
+			{
+				if (cache.moving_count < max_aim_moving)
+					cache.moving[cache.moving_count++] = point;
+				else
+					cache.valid = false;
+			}
+		}
+
+		// can't target stuff off screen
+		if (point->pos().y < top)
+		{
+			if (!moves && dist2(point->pos(), position) <= near_dist * near_dist)
+				entering = std::max(entering, point->pos().y);
+			continue;
+		}
+
+		float ldist2 = dist2line(dir, point->pos());
+		if (ldist2 < 0.f)
+			continue;
+
+		if (!moves && (still == nullptr || ldist2 < sdist2))
+		{
+			still = point;
+			sdist2 = ldist2;
+		}
+		if (best == nullptr || ldist2 < bdist2)
+		{
+			best = point;
+			bdist2 = ldist2;
+		}
+	}
+
+	cache.entering = entering;
+	cache.still = still;
+	nearest = best;
+	ndist2 = bdist2;
+}
+
+float Swinger::dist2line(const sf::Vector2f& dir, const sf::Vector2f& p)
+{
+	float dt = dot(p - position, dir) / (norm(p - position) * norm(dir));
+	if (dt <= 0.7071f)
+		return -1.f;
+	if (dist2(p, position) > max_target_dist2)
+		return -1.f;
+
+	float num = dir.y * p.x - dir.x * p.y + position.y * (position.x + dir.x) - position.x * (position.y + dir.y);
+	float ldist2 = (num * num) / norm2(dir);
+
+	return ldist2;
+}
+
+void Swinger::grapple()
+{
+	if (dead)
+		return;
+	if (nearest)
+	{
+		target(nearest);
+		sounds.play(SFX_GRAPPLE);
+	}
+}
+
+void Swinger::let_go()
+{
+	if (grapple_target)
+		sounds.play(SFX_LET_GO);
+	release();
+}
+
+void Swinger::release()
+{
+	reviving = false;
+	physics.grappling[body] = GRAPPLE_NONE;
+	ropes.release(rope_index);
+	if (grapple_target)
+	{
+		velocity += grapple_target->vel();
+		physics.vx[body] = velocity.x;
+		physics.vy[body] = velocity.y;
+	}
+	grapple_target = nullptr;
+	++targets_version;
+	return;
+}
+
+void Swinger::draw_rope_on(sf::RenderTexture& render_target)
+{
+	if (ropes.state[rope_index] == ROPE_NONE)
+		return;
+
+	// a strip through the nodes, as thick as the rope sprite at 4x
+	float half = rope.getLocalBounds().height * 2.f;
+	auto& color = rope.getColor();
+	for (unsigned int i = 0; i < RopePhysics::nodes; ++i)
+	{
+		sf::Vector2f p = ropes.node(rope_index, i);
+		sf::Vector2f along = ropes.node(rope_index, std::min(i + 1, RopePhysics::segments)) - ropes.node(rope_index, i ? i - 1 : 0);
+		float len = norm(along);
+		sf::Vector2f across = len > 0.f ? sf::Vector2f {-along.y, along.x} * (half / len) : sf::Vector2f {0.f, half};
+		float u = (i % 2) * 2.f;
+		rope_strip[2 * i] = sf::Vertex {p + across, color, sf::Vector2f {u, 0.f}};
+		rope_strip[2 * i + 1] = sf::Vertex {p - across, color, sf::Vector2f {u, 2.f}};
+	}
+	draw(render_target, rope_strip, sf::RenderStates {rope.getTexture()});
+}
+
+void Swinger::draw_on(sf::RenderTexture& render_target, const sf::View& camera)
+{
+	avatar.setPosition(position);
+	draw(render_target, avatar);
+
+	// textbox
+	if (is_speaking())
+	{
+		auto& center = camera.getCenter();
+		auto& size = camera.getSize();
+
+		sf::Vector2f boxcorner {0.f, center.y - size.y / 2.f + 20.f + 2.f * half_height};
+		if (index)
+		{
+			boxcorner.x = center.x + size.x / 2.f - 15.f - textbounds.width;
+		}
+		else
+		{
+			boxcorner.x = center.x - size.x / 2.f + 10.f;
+		}
+		sf::Vector2f boxcenter = boxcorner + sf::Vector2f{textbounds.width / 2.f, textbounds.height / 2.f};
+
+		textarrow.setPosition(boxcenter);
+		textarrow.setScale(dist(boxcenter, position) / 2.f, 1.f);
+		textarrow.setRotation(rad2deg(atan2f(position.y - boxcenter.y, position.x - boxcenter.x)));
+
+		// under the box, the cached bubble has the text in it already
+		draw(render_target, textarrow);
+		if (bubble)
+		{
+			bubble_sprite.setPosition(boxcorner);
+			draw(render_target, bubble_sprite);
+		}
+		else
+		{
+			textboxbox.setPosition(boxcorner);
+			draw(render_target, textboxbox);
+			textbox.setPosition(boxcorner);
+			draw(render_target, textbox);
+		}
+	}
+}
+
+void Swinger::draw_target_on(sf::RenderTexture& render_target)
+{
+	if (aiming)
+	{
+		aimbox.setPosition(position);
+		draw(render_target, aimbox);
+
+		if (nearest)
+		{
+			reticle.setPosition(nearest->pos());
+			reticle.setRotation(game_time * 10 + 45 * index);
+			draw(render_target, reticle);
+		}
+	}
+}
+
+void Swinger::draw_lives_on(sf::RenderTexture& render_target)
+{
+	for (int i = 0; i < lives; ++i)
+	{
+		avatar.setPosition(sf::Vector2f{index * winw - (30.f + i * 60.f) * (2 * index - 1), 30.f});
+		draw(render_target, avatar);
+	}
+}
+
+void Swinger::report(std::ostream& out)
+{
+	if (aim_calls == 0)
+		return;
+
+	out << "Aim: " << aim_hits << " of " << aim_calls << " aims from the cache (" << 100 * aim_hits / aim_calls << "%)" << std::endl;
+}
@@ -0,0 +1,250 @@
+#ifndef SWINGER_HPP
+#define SWINGER_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+
+#include "bubbles.hpp"
+#include "game.hpp"
+#include "physics.hpp"
+#include "point.hpp"
+#include "rope.hpp"
+#include "sound.hpp"
+
+// a player
+class Swinger : public Grappable
+{
+public:
+	static const int lament_count = 10;
+private:
+	std::string name;
+
+	SoundBoard& sounds;
+	SpeechBubbles& bubbles;
+
+	// position, velocity and grappling state live here, step() runs on all swingers at once
+	SwingerPhysics& physics;
+	unsigned int body;
+
+	// the rope drawn to grapple_target
+	RopePhysics& ropes;
+	unsigned int rope_index;
+	sf::VertexArray rope_strip {sf::TrianglesStrip, RopePhysics::nodes * 2};
+
+	sf::Sprite avatar;
+	sf::Sprite reticle;
+	sf::Sprite aimbox;
+	sf::Sprite rope;
+
+	Grappable* grapple_target = nullptr;
+	Grappable* nearest = nullptr;
+
+	float aiming = false;
+
+	float max_target_dist = 400.f;
+	float max_target_dist2;
+
+	// how far the aim can turn (as a cosine) or the player move before the cache is rescanned
+	float aim_cache_cos = 0.9998f;
+	float aim_cache_move = 2.f;
+	static const unsigned int max_aim_moving = 16;
+
+	// The last full scan of the points, reused while the aim, the player, the
+	// point set and everyone's targets hold steady. Players are few and always
+	// checked, and so are moving points that could come into reach.
+	struct AimCache
+	{
+		bool valid = false;
+		// unit aim direction
+		sf::Vector2f dir;
+		sf::Vector2f position;
+		uint32_t points_version = 0;
+		unsigned int targets_version = 0;
+		// lowest reachable point above the screen, it needs a rescan once it's on
+		float entering = 0.f;
+		// nearest point that stays put, or null
+		Point* still = nullptr;
+		Point* moving[max_aim_moving];
+		unsigned int moving_count = 0;
+	} aim_cache;
+
+	// bumped whenever any swinger's target changes, which changes what others can target
+	static unsigned int targets_version;
+	static uint64_t aim_calls;
+	static uint64_t aim_hits;
+
+	bool aim_cache_holds(const sf::Vector2f& dir, const sf::Vector2f& unit, float top, uint32_t points_version);
+	void scan_points(const sf::Vector2f& dir, const sf::Vector2f& unit, const std::vector<Swinger*>& players, const std::vector<Point*>& points, float top, uint32_t points_version, float& ndist2);
+
+	int need_center = 0;
+
+	int lives = 2;
+
+	float half_height;
+	float half_width;
+
+	int index;
+
+	// built once per name so dying doesn't allocate
+	std::string lament_name;
+	sf::String laments[lament_count];
+
+	// what's being said, drawn from the atlas, or textbox if it didn't fit
+	const SpeechBubbles::Bubble* bubble = nullptr;
+	sf::Sprite bubble_sprite;
+	sf::Text textbox;
+	sf::RectangleShape textboxbox;
+	// tick when the text goes away
+	unsigned int text_end_tick = 0;
+	sf::FloatRect textbounds;
+	sf::ConvexShape textarrow;
+
+	bool dead = false;
+	bool reviving = false;
+	unsigned int dead_tick = 0;
+public:
+	Swinger(int i, const std::string& nm, SoundBoard& sfx, SpeechBubbles& speech, SwingerPhysics& phys, RopePhysics& rope_phys, float x, const sf::Color& color, const sf::Texture& avatar_tex, const sf::Texture& reticle_tex,  const sf::Texture& aimbox_tex, const sf::Texture& rope_tex);
+
+	const std::string& get_name()
+	{
+		return name;
+	}
+
+	// show txt for time seconds of game time
+	void say(const sf::String& txt, float time);
+	void lament(const std::string& nm);
+	// build and bake the laments for nm ahead of time
+	void prepare_laments(const std::string& nm);
+	static std::string lament_line(const std::string& nm, int r);
+
+	int get_lives() const
+	{
+		return lives;
+	}
+
+	float get_half_height() const
+	{
+		return half_height;
+	}
+
+	float get_half_width() const
+	{
+		return half_width;
+	}
+
+	// how far away a point can be grappled
+	float get_reach() const
+	{
+		return max_target_dist;
+	}
+
+	const sf::Color& get_color() const
+	{
+		return avatar.getColor();
+	}
+
+	uint8_t telemetry_state() const;
+
+	void die();
+
+	bool is_dead() const
+	{
+		return dead;
+	}
+
+	bool need_revive() const;
+
+	bool is_reviving() const
+	{
+		return reviving;
+	}
+
+	void revive();
+
+	bool is_grappling() const
+	{
+		return physics.grappling[body] != GRAPPLE_NONE;
+	}
+
+	inline Grappable* target() const
+	{
+		return grapple_target;
+	}
+
+	void target(Grappable* new_target)
+	{
+		grapple_target = new_target;
+		++targets_version;
+		physics.grappling[body] = grapple_target ? GRAPPLE_PULLING : GRAPPLE_NONE;
+		if (grapple_target)
+			ropes.attach(rope_index, position, grapple_target->pos());
+		else
+			ropes.release(rope_index);
+	}
+
+	// hand the target's position to the physics before SwingerPhysics::step()
+	void prepare_step()
+	{
+		if (grapple_target)
+		{
+			physics.tx[body] = grapple_target->pos().x;
+			physics.ty[body] = grapple_target->pos().y;
+		}
+	}
+
+	// pick up the results of SwingerPhysics::step(), before RopePhysics::step()
+	void finish_step()
+	{
+		position = sf::Vector2f {physics.px[body], physics.py[body]};
+		velocity = sf::Vector2f {physics.vx[body], physics.vy[body]};
+		if (physics.events[body] & BODY_STARTED_SWINGING)
+			reviving = false;
+		if (grapple_target)
+			ropes.hold(rope_index, position, grapple_target->pos());
+	}
+
+	// aim and find nearest grapple to aim, points_version is PointPool::version()
+	void aim(const sf::Vector2f& dir, const std::vector<Swinger*>& players, const std::vector<Point*>& points, uint32_t points_version, const sf::View& camera);
+
+	void rebase(float dy)
+	{
+		Grappable::rebase(dy);
+		physics.py[body] = position.y;
+		// the points moved with us, the cache still holds
+		aim_cache.position.y += dy;
+		aim_cache.entering += dy;
+	}
+
+	void stop_aim()
+	{
+		aiming = false;
+		nearest = nullptr;
+	}
+
+	// return distance squared from p to the ray from position to position+dir (or -1 if not near ray)
+	float dist2line(const sf::Vector2f& dir, const sf::Vector2f& p);
+
+	void grapple();
+	void let_go();
+	// drop the grapple without any fanfare
+	void release();
+
+	bool is_speaking()
+	{
+		return game_tick < text_end_tick;
+	}
+
+	void draw_rope_on(sf::RenderTexture& render_target);
+	void draw_on(sf::RenderTexture& render_target, const sf::View& camera);
+	void draw_target_on(sf::RenderTexture& render_target);
+	void draw_lives_on(sf::RenderTexture& render_target);
+
+	// how often aiming was answered from the cache
+	static void report(std::ostream& out);
+};
+
+#endif
@@ -0,0 +1,53 @@
+#include <cstdio>
+#include <cstring>
+
+#include "telemetry.hpp"
+
+bool Telemetry::open(const std::string& path, uint32_t cap)
+{
+	header = nullptr;
+	records = nullptr;
+	count = 0;
+
+	// the last run's records are what's wanted after a crash, keep them
+	// before this run starts over
+	std::string previous = path + ".prev";
+	std::remove(previous.c_str());
+	std::rename(path.c_str(), previous.c_str());
+
+	if (!file.open_write(path, sizeof(TelemetryHeader) + (std::size_t)cap * sizeof(TelemetryRecord)))
+		return false;
+
+	std::memset(file.data(), 0, file.size());
+
+	header = (TelemetryHeader*)file.data();
+	records = (TelemetryRecord*)(header + 1);
+	capacity = cap;
+
+	header->version = telemetry_version;
+	header->record_size = sizeof(TelemetryRecord);
+	header->capacity = capacity;
+	// write magic last so readers never see a half-initialized header
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	std::memcpy(header->magic, telemetry_magic, sizeof(telemetry_magic));
+
+	return true;
+}
+
+void Telemetry::write(const TelemetryRecord& record)
+{
+	if (!header)
+		return;
+
+	TelemetryRecord& slot = records[count % capacity];
+
+	// mark the slot as being written
+	__atomic_store_n(&slot.seq, 0, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	std::memcpy((char*)&slot + sizeof(slot.seq), (const char*)&record + sizeof(record.seq), sizeof(record) - sizeof(record.seq));
+
+	++count;
+	__atomic_store_n(&slot.seq, count, __ATOMIC_RELEASE);
+	__atomic_store_n(&header->write_count, count, __ATOMIC_RELEASE);
+}
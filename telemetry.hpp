@@ -0,0 +1,89 @@
+#ifndef TELEMETRY_HPP
+#define TELEMETRY_HPP
+
+#include <cstdint>
+#include <string>
+
+#include "mapped_file.hpp"
+
+// Per-frame metrics written to a memory-mapped ring file.
+//
+// File layout: a TelemetryHeader followed by `capacity` TelemetryRecords.
+// Record n (counting from 0) lives in slot n % capacity. To tail the file,
+// read write_count, then for each new record check that its seq equals n + 1
+// before and after copying it (seq is 0 while the slot is being written).
+// Everything is little-endian and nothing is flushed explicitly, so the
+// kernel keeps the data even if the game crashes.
+
+const char telemetry_magic[8] = {'C', 'L', 'M', 'B', 'T', 'L', 'M', '1'};
+const uint32_t telemetry_version = 1;
+
+struct TelemetryHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t record_size;
+	uint32_t capacity;
+	uint32_t reserved;
+	// number of records ever written
+	uint64_t write_count;
+};
+
+// player state bits
+enum : uint8_t
+{
+	TELEMETRY_PULLING = 1,
+	TELEMETRY_SWINGING = 2,
+	TELEMETRY_AIMING = 4,
+	TELEMETRY_DEAD = 8,
+	TELEMETRY_REVIVING = 16,
+};
+
+// game state bits
+enum : uint8_t
+{
+	TELEMETRY_INTRO = 1,
+	TELEMETRY_GAMEOVER = 2,
+	TELEMETRY_CUTSCENE = 4,
+};
+
+struct TelemetryRecord
+{
+	uint64_t seq;
+	uint64_t frame;
+	float frame_ms;
+	float game_time;
+	uint16_t sim_steps;
+	uint16_t points;
+	uint16_t draw_calls;
+	uint8_t game_state;
+	uint8_t reserved;
+	// height above the floor
+	float height[2];
+	int8_t lives[2];
+	uint8_t player_state[2];
+	uint32_t reserved2;
+};
+
+static_assert(sizeof(TelemetryRecord) == 48, "telemetry record layout changed");
+
+class Telemetry
+{
+	MappedFile file;
+	TelemetryHeader* header = nullptr;
+	TelemetryRecord* records = nullptr;
+	uint32_t capacity = 0;
+	uint64_t count = 0;
+public:
+	bool open(const std::string& path, uint32_t cap);
+
+	inline bool is_open() const
+	{
+		return header != nullptr;
+	}
+
+	// copy a record into the ring, does nothing if telemetry is off
+	void write(const TelemetryRecord& record);
+};
+
+#endif
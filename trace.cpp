@@ -0,0 +1,96 @@
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "trace.hpp"
+
+std::atomic<bool> trace_enabled {false};
+
+static const unsigned int max_threads = 16;
+// published once made, trace_write() may read them from another thread
+static std::atomic<TraceBuffer*> buffers[max_threads];
+static std::atomic<unsigned int> buffer_count {0};
+static std::chrono::steady_clock::time_point origin;
+
+int64_t trace_now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count();
+}
+
+TraceBuffer* trace_buffer()
+{
+	thread_local TraceBuffer* buffer = nullptr;
+	if (buffer)
+		return buffer;
+
+	unsigned int i = buffer_count.load();
+	// claim a slot, a new buffer is only visible once it's in place
+	do
+	{
+		if (i == max_threads)
+			return nullptr;
+	}
+	while (!buffer_count.compare_exchange_weak(i, i + 1));
+
+	buffer = new TraceBuffer;
+	buffers[i].store(buffer, std::memory_order_release);
+	return buffer;
+}
+
+void trace_thread_name(const char* name)
+{
+	if (TraceBuffer* buffer = trace_buffer())
+		buffer->thread_name = name;
+}
+
+void trace_start()
+{
+	origin = std::chrono::steady_clock::now();
+	trace_thread_name("main");
+	trace_enabled.store(true, std::memory_order_relaxed);
+}
+
+long trace_write(const std::string& path)
+{
+	std::FILE* out = std::fopen(path.c_str(), "w");
+	if (!out)
+		return -1;
+
+	std::fprintf(out, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+	std::fprintf(out, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": {\"name\": \"climb\"}}");
+
+	long written = 0;
+	std::vector<TraceEvent> events;
+	unsigned int threads = buffer_count.load();
+	for (unsigned int t = 0; t < threads; ++t)
+	{
+		TraceBuffer* buffer = buffers[t].load(std::memory_order_acquire);
+		// claimed but not made yet
+		if (!buffer)
+			continue;
+
+		std::fprintf(out, ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %u, \"args\": {\"name\": \"%s\"}}", t + 1, buffer->thread_name);
+
+		// copy out, then throw away anything the owner may have overwritten meanwhile
+		uint64_t end = buffer->count.load(std::memory_order_acquire);
+		uint64_t begin = end > TraceBuffer::capacity ? end - TraceBuffer::capacity : 0;
+		events.clear();
+		for (uint64_t n = begin; n < end; ++n)
+			events.push_back(buffer->events[n % TraceBuffer::capacity]);
+		uint64_t now = buffer->count.load(std::memory_order_acquire);
+		uint64_t valid = now > TraceBuffer::capacity ? now - TraceBuffer::capacity : 0;
+		std::size_t skip = valid > begin ? valid - begin : 0;
+
+		for (std::size_t i = skip; i < events.size(); ++i)
+		{
+			const TraceEvent& event = events[i];
+			std::fprintf(out, ",\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f}",
+				event.name, t + 1, event.start / 1000.0, (event.end - event.start) / 1000.0);
+			++written;
+		}
+	}
+
+	std::fprintf(out, "\n]}\n");
+	bool ok = std::fclose(out) == 0;
+	return ok ? written : -1;
+}
@@ -0,0 +1,99 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Named spans for a timeline viewer. Every thread records into its own
+// preallocated ring that only it writes, so recording never locks;
+// trace_write() dumps whatever the rings hold as Chrome trace-event JSON,
+// which chrome://tracing and ui.perfetto.dev open. A span checks
+// trace_enabled once, when it starts, and keeps the thread's buffer if it's
+// on; ending it only looks at that. While tracing is off a span costs a
+// relaxed load and a branch the compiler folds the end into.
+
+// read by every thread, relaxed is enough to start and stop recording
+extern std::atomic<bool> trace_enabled;
+
+struct TraceEvent
+{
+	// a string literal
+	const char* name;
+	// nanoseconds since trace_start()
+	int64_t start;
+	int64_t end;
+};
+
+class TraceBuffer
+{
+public:
+	// 1.5 MB a thread, several minutes of spans at 60 FPS
+	static const unsigned int capacity = 1 << 16;
+
+	TraceEvent events[capacity];
+	// events ever recorded, bumped after the event is in place
+	std::atomic<uint64_t> count {0};
+	const char* thread_name = "worker";
+
+	inline void record(const char* name, int64_t start, int64_t end)
+	{
+		uint64_t n = count.load(std::memory_order_relaxed);
+		TraceEvent& event = events[n % capacity];
+		event.name = name;
+		event.start = start;
+		event.end = end;
+		count.store(n + 1, std::memory_order_release);
+	}
+};
+
+int64_t trace_now();
+
+// the calling thread's buffer, made the first time it records (nullptr if there are too many threads)
+TraceBuffer* trace_buffer();
+
+// name the calling thread in the trace, this also makes its buffer
+void trace_thread_name(const char* name);
+
+// start recording, call from the main thread
+void trace_start();
+
+// write everything recorded so far, returns the number of events or -1
+long trace_write(const std::string& path);
+
+class TraceSpan
+{
+	// the calling thread's buffer, left null while tracing is off
+	TraceBuffer* buffer = nullptr;
+	const char* name;
+	int64_t start = 0;
+public:
+	explicit TraceSpan(const char* n) : name(n)
+	{
+		if (trace_enabled.load(std::memory_order_relaxed))
+		{
+			buffer = trace_buffer();
+			start = trace_now();
+		}
+	}
+
+	TraceSpan(const TraceSpan&) = delete;
+	TraceSpan& operator=(const TraceSpan&) = delete;
+
+	~TraceSpan()
+	{
+		end();
+	}
+
+	// finish before going out of scope
+	inline void end()
+	{
+		if (buffer)
+		{
+			buffer->record(name, start, trace_now());
+			buffer = nullptr;
+		}
+	}
+};
+
+#endif